@@ -8,15 +8,18 @@ using namespace lunasvg;
 int help()
 {
     std::cout << "Usage: \n"
-                 "   svg2png [filename] [resolution] [bgColor]\n\n"
+                 "   svg2png [filename] [resolution] [bgColor] [format]\n\n"
+                 "Formats: \n"
+                 "    png (default), qoi, pam, ppm\n\n"
                  "Examples: \n"
                  "    $ svg2png input.svg\n"
                  "    $ svg2png input.svg 512x512\n"
-                 "    $ svg2png input.svg 512x512 0xff00ffff\n\n";
+                 "    $ svg2png input.svg 512x512 0xff00ffff\n"
+                 "    $ svg2png input.svg 512x512 0x00000000 qoi\n\n";
     return 1;
 }
 
-bool setup(int argc, char** argv, std::string& filename, std::uint32_t& width, std::uint32_t& height, std::uint32_t& bgColor)
+bool setup(int argc, char** argv, std::string& filename, std::uint32_t& width, std::uint32_t& height, std::uint32_t& bgColor, std::string& format)
 {
     if(argc > 1) filename.assign(argv[1]);
     if(argc > 2) {
@@ -35,6 +38,13 @@ bool setup(int argc, char** argv, std::string& filename, std::uint32_t& width, s
         ss >> std::hex >> bgColor;
     }
 
+    if(argc > 4) {
+        format.assign(argv[4]);
+        if(format != "png" && format != "qoi" && format != "pam" && format != "ppm") {
+            return false;
+        }
+    }
+
     return argc > 1;
 }
 
@@ -43,7 +53,8 @@ int main(int argc, char* argv[])
     std::string filename;
     std::uint32_t width = 0, height = 0;
     std::uint32_t bgColor = 0x00000000;
-    if(!setup(argc, argv, filename, width, height, bgColor)) {
+    std::string format("png");
+    if(!setup(argc, argv, filename, width, height, bgColor, format)) {
         return help();
     }
 
@@ -59,9 +70,24 @@ int main(int argc, char* argv[])
 
     auto lastSlashIndex = filename.find_last_of("/\\");
     auto basename = lastSlashIndex == std::string::npos ? filename : filename.substr(lastSlashIndex + 1);
-    basename.append(".png");
+    basename.append(".").append(format);
+
+    bool success = false;
+    if(format == "qoi") {
+        success = bitmap.writeToQoi(basename);
+    } else if(format == "pam") {
+        success = bitmap.writeToPam(basename);
+    } else if(format == "ppm") {
+        success = bitmap.writeToPpm(basename);
+    } else {
+        success = bitmap.writeToPng(basename);
+    }
+
+    if(!success) {
+        std::cerr << "Failed to write file: " << basename << std::endl;
+        return 1;
+    }
 
-    bitmap.writeToPng(basename);
-    std::cout << "Generated PNG file: " << basename << std::endl;
+    std::cout << "Generated " << format << " file: " << basename << std::endl;
     return 0;
 }
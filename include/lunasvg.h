@@ -126,12 +126,62 @@ LUNASVG_API bool lunasvg_add_font_face_from_file(const char* family, bool bold,
 */
 LUNASVG_API bool lunasvg_add_font_face_from_data(const char* family, bool bold, bool italic, const void* data, size_t length, lunasvg_destroy_func_t destroy_func, void* closure);
 
+/**
+* @brief Add all font faces from a font file or collection in memory to the cache.
+*
+* Each face is registered under the family name and style read from its naming table, and is only
+* loaded from the data when it is first used. The data is not copied.
+*
+* @param data A pointer to the memory buffer containing the font data, such as a TrueType collection.
+* @param length The size of the memory buffer in bytes.
+* @param destroy_func Callback function to free the memory buffer when it is no longer needed.
+* @param closure User-defined pointer passed to the `destroy_func` callback.
+* @return The number of font faces added to the cache.
+*/
+LUNASVG_API int lunasvg_add_font_collection_from_data(const void* data, size_t length, lunasvg_destroy_func_t destroy_func, void* closure);
+
+/**
+* @brief Set the maximum amount of memory used by the shared cache of decoded images.
+*
+* Images embedded in `<image>` elements as `data:` URLs are decoded once and shared across all documents,
+* keyed by their `href` value. Images referenced by file path are not cached, so changes on disk are always picked up.
+* The least recently used images are released first when the limit is exceeded.
+*
+* @param capacity The cache capacity in bytes of decoded pixel data and keys. Use `0` to disable caching.
+*/
+LUNASVG_API void lunasvg_set_image_cache_capacity(size_t capacity);
+
 #ifdef __cplusplus
 }
 #endif
 
 namespace lunasvg {
 
+/**
+ * @brief Pixel layouts that bitmap data can be converted to.
+ *
+ * Apart from `ARGB32_Premultiplied`, the formats describe the order of the channels in memory, independent of the host endianness.
+ */
+enum class PixelFormat {
+    ARGB32_Premultiplied, ///< Native-endian 32-bit premultiplied ARGB, the bitmap format.
+    RGBA32_Premultiplied, ///< Bytes in R, G, B, A order, premultiplied.
+    RGBA32, ///< Bytes in R, G, B, A order, non-premultiplied.
+    BGRA32_Premultiplied, ///< Bytes in B, G, R, A order, premultiplied.
+    A8 ///< 8-bit alpha only.
+};
+
+/**
+ * @brief Per-row filters applied before PNG compression.
+ */
+enum class PngFilter {
+    None, ///< No filtering.
+    Sub, ///< Difference from the pixel to the left.
+    Up, ///< Difference from the pixel above.
+    Average, ///< Difference from the average of the left and above pixels.
+    Paeth, ///< Difference from the Paeth predictor.
+    Adaptive ///< Picks the filter per row that is most likely to compress best.
+};
+
 /**
 * @note Bitmap pixel format is ARGB32_Premultiplied.
 */
@@ -237,6 +287,16 @@ public:
      */
     void convertToRGBA();
 
+    /**
+     * @brief Converts the bitmap pixel data into a caller-provided buffer in the specified format.
+     * @note The bitmap itself is left unmodified, and each pixel is read and written exactly once.
+     * @param format The pixel format of the destination buffer.
+     * @param data A pointer to the destination buffer, at least `stride * height()` bytes.
+     * @param stride The number of bytes per row of the destination buffer.
+     * @return True if the pixel data was converted successfully, false otherwise.
+     */
+    bool convertTo(PixelFormat format, uint8_t* data, int stride) const;
+
     /**
      * @brief Checks if the bitmap is null.
      * @return True if the bitmap is null, false otherwise.
@@ -265,6 +325,74 @@ public:
      */
     bool writeToPng(lunasvg_write_func_t callback, void* closure) const;
 
+    /**
+     * @brief Writes the bitmap to a PNG file using the specified compression settings.
+     * @param filename The name of the file to write.
+     * @param compressionLevel The compression level from 0 (store only, fastest) to 9 (smallest output), or -1 for the default.
+     * @param filter The row filter to apply before compression.
+     * @return True if the file was written successfully, false otherwise.
+     */
+    bool writeToPng(const std::string& filename, int compressionLevel, PngFilter filter = PngFilter::Adaptive) const;
+
+    /**
+     * @brief Writes the bitmap to a PNG stream using the specified compression settings.
+     * @note The output is produced row by row and passed to the callback as it is compressed, so memory use stays bounded.
+     * @param callback Callback function for writing data.
+     * @param closure User-defined data passed to the callback.
+     * @param compressionLevel The compression level from 0 (store only, fastest) to 9 (smallest output), or -1 for the default.
+     * @param filter The row filter to apply before compression.
+     * @return True if successful, false otherwise.
+     */
+    bool writeToPng(lunasvg_write_func_t callback, void* closure, int compressionLevel, PngFilter filter = PngFilter::Adaptive) const;
+
+    /**
+     * @brief Writes the bitmap to a QOI file.
+     * @note QOI is lossless and much cheaper to encode than PNG.
+     * @param filename The name of the file to write.
+     * @return True if the file was written successfully, false otherwise.
+     */
+    bool writeToQoi(const std::string& filename) const;
+
+    /**
+     * @brief Writes the bitmap to a QOI stream.
+     * @param callback Callback function for writing data.
+     * @param closure User-defined data passed to the callback.
+     * @return True if successful, false otherwise.
+     */
+    bool writeToQoi(lunasvg_write_func_t callback, void* closure) const;
+
+    /**
+     * @brief Writes the bitmap to a PAM file.
+     * @note PAM stores uncompressed non-premultiplied RGBA pixels.
+     * @param filename The name of the file to write.
+     * @return True if the file was written successfully, false otherwise.
+     */
+    bool writeToPam(const std::string& filename) const;
+
+    /**
+     * @brief Writes the bitmap to a PAM stream.
+     * @param callback Callback function for writing data.
+     * @param closure User-defined data passed to the callback.
+     * @return True if successful, false otherwise.
+     */
+    bool writeToPam(lunasvg_write_func_t callback, void* closure) const;
+
+    /**
+     * @brief Writes the bitmap to a PPM file.
+     * @note PPM stores uncompressed RGB pixels; the alpha channel is dropped.
+     * @param filename The name of the file to write.
+     * @return True if the file was written successfully, false otherwise.
+     */
+    bool writeToPpm(const std::string& filename) const;
+
+    /**
+     * @brief Writes the bitmap to a PPM stream.
+     * @param callback Callback function for writing data.
+     * @param closure User-defined data passed to the callback.
+     * @return True if successful, false otherwise.
+     */
+    bool writeToPpm(lunasvg_write_func_t callback, void* closure) const;
+
     /**
      * @internal
      */
@@ -750,6 +878,24 @@ public:
      */
     Bitmap renderToBitmap(int width = -1, int height = -1, uint32_t backgroundColor = 0x00000000) const;
 
+    /**
+     * @brief Renders the document into a caller-provided pixel buffer in the specified format.
+     *
+     * The document is rendered directly into the buffer and then converted in place if the
+     * format differs from the native bitmap format. Only A8 buffers whose rows are too narrow
+     * to hold 32-bit pixels go through a scratch bitmap. The previous contents of the buffer
+     * are replaced.
+     *
+     * @param data A pointer to the destination buffer, at least `stride * height` bytes.
+     * @param width The width of the buffer in pixels.
+     * @param height The height of the buffer in pixels.
+     * @param stride The number of bytes per row of the buffer.
+     * @param format The pixel format of the buffer.
+     * @param matrix The root transformation matrix.
+     * @return True if the document was rendered successfully, false otherwise.
+     */
+    bool renderToBuffer(uint8_t* data, int width, int height, int stride, PixelFormat format, const Matrix& matrix = Matrix()) const;
+
     /**
      * @brief Returns the topmost element under the specified point.
      * @param x The x-coordinate in viewport space.
@@ -754,6 +754,16 @@ typedef struct plutovg_text_iterator {
  */
 typedef unsigned int plutovg_codepoint_t;
 
+/**
+ * @brief Represents a run of text drawn from a given origin.
+ */
+typedef struct plutovg_text_run {
+    const void* text; ///< Pointer to the text data.
+    int length; ///< Length of the text data, or -1 if the data is null-terminated.
+    float x; ///< The x-coordinate of the origin.
+    float y; ///< The y-coordinate of the origin.
+} plutovg_text_run_t;
+
 /**
  * @brief Initializes a text iterator.
  *
@@ -788,6 +798,9 @@ typedef struct plutovg_font_face plutovg_font_face_t;
 /**
  * @brief Loads a font face from a file.
  *
+ * The file is memory-mapped read-only where possible, so the font data is backed by the
+ * system page cache and shared between processes instead of being copied into the heap.
+ *
  * @param filename Path to the font file.
  * @param ttcindex Index of the font face within a TrueType Collection (TTC).
  * @return A pointer to the loaded `plutovg_font_face_t` object, or `NULL` on failure.
@@ -959,6 +972,22 @@ PLUTOVG_API void plutovg_font_face_cache_add(plutovg_font_face_cache_t* cache, c
  */
 PLUTOVG_API bool plutovg_font_face_cache_add_file(plutovg_font_face_cache_t* cache, const char* family, bool bold, bool italic, const char* filename, int ttcindex);
 
+/**
+ * @brief Add all font faces from a font file or collection in memory to the cache.
+ *
+ * Only the naming tables are read up front to register each face under its family and style.
+ * A face is loaded from the data the first time it is retrieved from the cache, and the data is
+ * never copied.
+ *
+ * @param cache A pointer to a `plutovg_font_face_cache_t` object.
+ * @param data A pointer to the font data (TrueType, OpenType, or font collection).
+ * @param length The length of the font data in bytes.
+ * @param destroy_func A function called when the data is no longer referenced by the cache or any of its faces, or NULL.
+ * @param closure A pointer passed to `destroy_func`.
+ * @return The number of faces added to the cache.
+ */
+PLUTOVG_API int plutovg_font_face_cache_load_data(plutovg_font_face_cache_t* cache, const void* data, unsigned int length, plutovg_destroy_func_t destroy_func, void* closure);
+
 /**
  * @brief Retrieve a font face from the cache by family and style.
  *
@@ -990,6 +1019,21 @@ PLUTOVG_API int plutovg_font_face_cache_load_file(plutovg_font_face_cache_t* cac
  */
 PLUTOVG_API int plutovg_font_face_cache_load_dir(plutovg_font_face_cache_t* cache, const char* dirname);
 
+/**
+ * @brief Load all font faces from files in a directory recursively, using a persistent font index.
+ *
+ * Behaves like `plutovg_font_face_cache_load_dir()`, but records the scanned faces in the index file
+ * so that subsequent calls, including from other processes, only rescan directories whose
+ * modification time has changed. The index is rewritten when it is missing or out of date.
+ * An index file should always be used with the same set of directories.
+ *
+ * @param cache A pointer to a `plutovg_font_face_cache_t` object.
+ * @param dirname Path to the directory containing font files.
+ * @param index_filename Path to the font index file.
+ * @return The number of faces successfully loaded, or `-1` if font face cache loading is disabled.
+ */
+PLUTOVG_API int plutovg_font_face_cache_load_dir_with_index(plutovg_font_face_cache_t* cache, const char* dirname, const char* index_filename);
+
 /**
  * @brief Load all available system font faces and add them to the cache.
  *
@@ -1000,6 +1044,18 @@ PLUTOVG_API int plutovg_font_face_cache_load_dir(plutovg_font_face_cache_t* cach
  */
 PLUTOVG_API int plutovg_font_face_cache_load_sys(plutovg_font_face_cache_t* cache);
 
+/**
+ * @brief Load all available system font faces, using a persistent font index.
+ *
+ * Behaves like `plutovg_font_face_cache_load_sys()`, but reuses the faces recorded in the index file
+ * for system font directories whose modification time is unchanged.
+ *
+ * @param cache A pointer to a `plutovg_font_face_cache_t` object.
+ * @param index_filename Path to the font index file.
+ * @return The number of faces successfully loaded, or `-1` if font face cache loading is disabled.
+ */
+PLUTOVG_API int plutovg_font_face_cache_load_sys_with_index(plutovg_font_face_cache_t* cache, const char* index_filename);
+
 /**
  * @brief Represents a color with red, green, blue, and alpha components.
  */
@@ -1247,6 +1303,34 @@ PLUTOVG_API int plutovg_surface_get_stride(const plutovg_surface_t* surface);
  */
 PLUTOVG_API void plutovg_surface_clear(plutovg_surface_t* surface, const plutovg_color_t* color);
 
+/**
+ * @brief Notifies the surface that its pixels were modified outside of plutovg.
+ *
+ * Drawing through a canvas and `plutovg_surface_clear` do this automatically. Call it after
+ * writing to the pixel data directly, so that mipmaps built for `PLUTOVG_TEXTURE_FILTER_BILINEAR`
+ * are discarded and rebuilt from the new content.
+ *
+ * @param surface Pointer to the `plutovg_surface_t` object.
+ */
+PLUTOVG_API void plutovg_surface_mark_dirty(plutovg_surface_t* surface);
+
+/**
+ * @brief Defines the per-row filter used when encoding PNG images.
+ */
+typedef enum {
+    PLUTOVG_PNG_FILTER_NONE, ///< No filtering.
+    PLUTOVG_PNG_FILTER_SUB, ///< Difference from the pixel to the left.
+    PLUTOVG_PNG_FILTER_UP, ///< Difference from the pixel above.
+    PLUTOVG_PNG_FILTER_AVERAGE, ///< Difference from the average of the left and above pixels.
+    PLUTOVG_PNG_FILTER_PAETH, ///< Difference from the Paeth predictor.
+    PLUTOVG_PNG_FILTER_ADAPTIVE ///< Picks the filter per row that is most likely to compress best.
+} plutovg_png_filter_t;
+
+/**
+ * @brief The compression level used by the PNG writers when none is specified.
+ */
+#define PLUTOVG_PNG_DEFAULT_COMPRESSION_LEVEL 6
+
 /**
  * @brief Writes the surface to a PNG file.
  *
@@ -1287,6 +1371,163 @@ PLUTOVG_API bool plutovg_surface_write_to_png_stream(const plutovg_surface_t* su
  */
 PLUTOVG_API bool plutovg_surface_write_to_jpg_stream(const plutovg_surface_t* surface, plutovg_write_func_t write_func, void* closure, int quality);
 
+/**
+ * @brief Writes the surface to a PNG file using the specified compression settings.
+ *
+ * @param surface Pointer to the `plutovg_surface_t` object.
+ * @param filename Path to the output PNG file.
+ * @param compression_level Compression level from 0 (store only, fastest) to 9 (smallest output); negative values select the default and values above 9 are clamped to 9.
+ * @param filter The row filter to apply before compression; values outside the enumeration fall back to `PLUTOVG_PNG_FILTER_ADAPTIVE`.
+ * @return `true` if successful, `false` otherwise.
+ */
+PLUTOVG_API bool plutovg_surface_write_to_png_with_options(const plutovg_surface_t* surface, const char* filename, int compression_level, plutovg_png_filter_t filter);
+
+/**
+ * @brief Writes the surface to a PNG stream using the specified compression settings.
+ *
+ * The image is encoded row by row and the compressed data is passed to `write_func`
+ * as it is produced, so memory use is bounded regardless of the image size.
+ *
+ * @param surface Pointer to the `plutovg_surface_t` object.
+ * @param write_func Callback function for writing data.
+ * @param closure User-defined data passed to the callback.
+ * @param compression_level Compression level from 0 (store only, fastest) to 9 (smallest output); negative values select the default and values above 9 are clamped to 9.
+ * @param filter The row filter to apply before compression; values outside the enumeration fall back to `PLUTOVG_PNG_FILTER_ADAPTIVE`.
+ * @return `true` if successful, `false` otherwise.
+ */
+PLUTOVG_API bool plutovg_surface_write_to_png_stream_with_options(const plutovg_surface_t* surface, plutovg_write_func_t write_func, void* closure, int compression_level, plutovg_png_filter_t filter);
+
+/**
+ * @brief Writes the surface to a QOI file.
+ *
+ * QOI is a lossless format that encodes in a single pass with no entropy coding, making it much cheaper to write than PNG.
+ *
+ * @param surface Pointer to the `plutovg_surface_t` object.
+ * @param filename Path to the output QOI file.
+ * @return `true` if successful, `false` otherwise.
+ */
+PLUTOVG_API bool plutovg_surface_write_to_qoi(const plutovg_surface_t* surface, const char* filename);
+
+/**
+ * @brief Writes the surface to a QOI stream.
+ *
+ * QOI is a lossless format that encodes in a single pass with no entropy coding, making it much cheaper to write than PNG.
+ *
+ * @param surface Pointer to the `plutovg_surface_t` object.
+ * @param write_func Callback function for writing data.
+ * @param closure User-defined data passed to the callback.
+ * @return `true` if successful, `false` otherwise.
+ */
+PLUTOVG_API bool plutovg_surface_write_to_qoi_stream(const plutovg_surface_t* surface, plutovg_write_func_t write_func, void* closure);
+
+/**
+ * @brief Writes the surface to a PAM file.
+ *
+ * PAM (Netpbm P7) stores the non-premultiplied RGBA pixels uncompressed behind a short text header.
+ *
+ * @param surface Pointer to the `plutovg_surface_t` object.
+ * @param filename Path to the output PAM file.
+ * @return `true` if successful, `false` otherwise.
+ */
+PLUTOVG_API bool plutovg_surface_write_to_pam(const plutovg_surface_t* surface, const char* filename);
+
+/**
+ * @brief Writes the surface to a PAM stream.
+ *
+ * PAM (Netpbm P7) stores the non-premultiplied RGBA pixels uncompressed behind a short text header.
+ *
+ * @param surface Pointer to the `plutovg_surface_t` object.
+ * @param write_func Callback function for writing data.
+ * @param closure User-defined data passed to the callback.
+ * @return `true` if successful, `false` otherwise.
+ */
+PLUTOVG_API bool plutovg_surface_write_to_pam_stream(const plutovg_surface_t* surface, plutovg_write_func_t write_func, void* closure);
+
+/**
+ * @brief Writes the surface to a PPM file.
+ *
+ * PPM (Netpbm P6) stores the RGB pixels uncompressed; the alpha channel is dropped, which composites the image over black.
+ *
+ * @param surface Pointer to the `plutovg_surface_t` object.
+ * @param filename Path to the output PPM file.
+ * @return `true` if successful, `false` otherwise.
+ */
+PLUTOVG_API bool plutovg_surface_write_to_ppm(const plutovg_surface_t* surface, const char* filename);
+
+/**
+ * @brief Writes the surface to a PPM stream.
+ *
+ * PPM (Netpbm P6) stores the RGB pixels uncompressed; the alpha channel is dropped, which composites the image over black.
+ *
+ * @param surface Pointer to the `plutovg_surface_t` object.
+ * @param write_func Callback function for writing data.
+ * @param closure User-defined data passed to the callback.
+ * @return `true` if successful, `false` otherwise.
+ */
+PLUTOVG_API bool plutovg_surface_write_to_ppm_stream(const plutovg_surface_t* surface, plutovg_write_func_t write_func, void* closure);
+
+/**
+ * @brief Defines the pixel layouts that surface data can be converted to.
+ *
+ * The byte-order formats describe the order of the channels in memory, independent of the host endianness.
+ */
+typedef enum {
+    PLUTOVG_PIXEL_FORMAT_ARGB32_PREMULTIPLIED, ///< Native-endian 32-bit premultiplied ARGB, the surface format.
+    PLUTOVG_PIXEL_FORMAT_RGBA32_PREMULTIPLIED, ///< Bytes in R, G, B, A order, premultiplied.
+    PLUTOVG_PIXEL_FORMAT_RGBA32, ///< Bytes in R, G, B, A order, non-premultiplied.
+    PLUTOVG_PIXEL_FORMAT_BGRA32_PREMULTIPLIED, ///< Bytes in B, G, R, A order, premultiplied.
+    PLUTOVG_PIXEL_FORMAT_A8 ///< 8-bit alpha only.
+} plutovg_pixel_format_t;
+
+/**
+ * @brief Gets the number of bytes used by a single pixel in the specified format.
+ *
+ * @param format The pixel format.
+ * @return The number of bytes per pixel.
+ */
+PLUTOVG_API int plutovg_pixel_format_get_bytes_per_pixel(plutovg_pixel_format_t format);
+
+/**
+ * @brief Checks whether the specified format has the same memory layout as surface data.
+ *
+ * This is always the case for `PLUTOVG_PIXEL_FORMAT_ARGB32_PREMULTIPLIED`, and for
+ * `PLUTOVG_PIXEL_FORMAT_BGRA32_PREMULTIPLIED` on little-endian hosts.
+ *
+ * @param format The pixel format.
+ * @return `true` if surface data needs no conversion to this format, `false` otherwise.
+ */
+PLUTOVG_API bool plutovg_pixel_format_is_native(plutovg_pixel_format_t format);
+
+/**
+ * @brief Converts premultiplied ARGB pixel data to the specified pixel format.
+ *
+ * Every source row is read once and written directly to the destination, so no
+ * intermediate buffer is needed. The destination may overlap the source as long
+ * as `dst_stride` is not greater than `src_stride`.
+ *
+ * @param dst Pointer to the destination buffer.
+ * @param dst_stride Number of bytes per row in the destination buffer.
+ * @param src Pointer to the source buffer in ARGB premultiplied format.
+ * @param src_stride Number of bytes per row in the source buffer.
+ * @param width Image width in pixels.
+ * @param height Image height in pixels.
+ * @param format The destination pixel format.
+ */
+PLUTOVG_API void plutovg_convert_argb_to_format(unsigned char* dst, int dst_stride, const unsigned char* src, int src_stride, int width, int height, plutovg_pixel_format_t format);
+
+/**
+ * @brief Converts the surface pixel data to the specified pixel format.
+ *
+ * The surface itself is left unmodified.
+ *
+ * @param surface Pointer to the `plutovg_surface_t` object.
+ * @param data Pointer to the destination buffer, at least `stride * height` bytes.
+ * @param stride Number of bytes per row in the destination buffer.
+ * @param format The destination pixel format.
+ * @return `true` if successful, `false` if the stride is too small for the format.
+ */
+PLUTOVG_API bool plutovg_surface_convert_to(const plutovg_surface_t* surface, unsigned char* data, int stride, plutovg_pixel_format_t format);
+
 /**
  * @brief Converts pixel data from premultiplied ARGB to RGBA format.
  *
@@ -1323,6 +1564,14 @@ typedef enum {
     PLUTOVG_TEXTURE_TYPE_TILED ///< Tiled texture.
 } plutovg_texture_type_t;
 
+/**
+ * @brief Defines how texture pixels are sampled when a texture is scaled or rotated.
+ */
+typedef enum {
+    PLUTOVG_TEXTURE_FILTER_NEAREST, ///< Nearest-neighbor sampling, the fastest.
+    PLUTOVG_TEXTURE_FILTER_BILINEAR ///< Bilinear sampling; downscales by more than half sample a mipmap of the surface.
+} plutovg_texture_filter_t;
+
 /**
  * @brief Defines the spread method for gradients.
  */
@@ -1486,6 +1735,14 @@ typedef enum {
     PLUTOVG_LINE_JOIN_BEVEL ///< Beveled join with a flattened corner.
 } plutovg_line_join_t;
 
+/**
+ * @brief Defines the scan converters used to turn paths into pixel coverage.
+ */
+typedef enum {
+    PLUTOVG_RASTERIZER_CELL, ///< Cell-based scanline rasterizer, suited to shapes of any size.
+    PLUTOVG_RASTERIZER_ANALYTIC ///< Dense analytic-area rasterizer, faster for small shapes; large shapes fall back to the cell rasterizer.
+} plutovg_rasterizer_t;
+
 /**
  * @brief Represents a drawing context.
  */
@@ -1530,6 +1787,72 @@ PLUTOVG_API int plutovg_canvas_get_reference_count(const plutovg_canvas_t* canva
  */
 PLUTOVG_API plutovg_surface_t* plutovg_canvas_get_surface(const plutovg_canvas_t* canvas);
 
+/**
+ * @brief Selects the rasterizer used for all subsequent drawing on the canvas.
+ *
+ * If not set, the default rasterizer is `PLUTOVG_RASTERIZER_CELL`.
+ *
+ * @param canvas A pointer to a `plutovg_canvas_t` object.
+ * @param rasterizer The rasterizer.
+ */
+PLUTOVG_API void plutovg_canvas_set_rasterizer(plutovg_canvas_t* canvas, plutovg_rasterizer_t rasterizer);
+
+/**
+ * @brief Retrieves the rasterizer used by the canvas.
+ *
+ * @param canvas A pointer to a `plutovg_canvas_t` object.
+ * @return The current rasterizer.
+ */
+PLUTOVG_API plutovg_rasterizer_t plutovg_canvas_get_rasterizer(const plutovg_canvas_t* canvas);
+
+/**
+ * @brief Sets the flatness used to approximate curves on the canvas.
+ *
+ * The flatness is the maximum distance, in device pixels, between a curve and the line segments
+ * that replace it when it is filled, stroked or dashed. Larger values trade invisible accuracy for
+ * speed, which suits thumbnails and small icons.
+ * Positive values are clamped to the range [1/64, 4]. Once set, dashes are flattened in device
+ * space and curves that fit within the flatness are drawn as single lines.
+ *
+ * A value of zero or less restores the default, which keeps the historical output exactly:
+ * curves are rasterized at a fixed `0.125` pixel tolerance and dashes are flattened at a fixed
+ * tolerance in user space.
+ *
+ * @param canvas A pointer to a `plutovg_canvas_t` object.
+ * @param flatness The flatness, in device pixels, or zero for the default.
+ */
+PLUTOVG_API void plutovg_canvas_set_flatness(plutovg_canvas_t* canvas, float flatness);
+
+/**
+ * @brief Retrieves the flatness used to approximate curves on the canvas.
+ *
+ * @param canvas A pointer to a `plutovg_canvas_t` object.
+ * @return The current flatness, in device pixels, or zero if none was set.
+ */
+PLUTOVG_API float plutovg_canvas_get_flatness(const plutovg_canvas_t* canvas);
+
+/**
+ * @brief Enables or disables the glyph mask cache for text filled on the canvas.
+ *
+ * When enabled, axis-aligned text up to 256 device pixels is drawn from coverage masks cached
+ * per glyph, font size and horizontal quarter-pixel position, with the baseline snapped to whole
+ * pixels. Repeated text renders much faster, but edge pixels may differ slightly from text
+ * rasterized as outlines. Runs whose glyph boxes overlap are always rasterized as outlines.
+ * The cache is disabled by default.
+ *
+ * @param canvas A pointer to a `plutovg_canvas_t` object.
+ * @param enabled `true` to draw text from cached glyph masks, `false` to rasterize outlines.
+ */
+PLUTOVG_API void plutovg_canvas_set_glyph_cache(plutovg_canvas_t* canvas, bool enabled);
+
+/**
+ * @brief Tells whether the glyph mask cache is enabled on the canvas.
+ *
+ * @param canvas A pointer to a `plutovg_canvas_t` object.
+ * @return `true` if text is drawn from cached glyph masks, `false` otherwise.
+ */
+PLUTOVG_API bool plutovg_canvas_get_glyph_cache(const plutovg_canvas_t* canvas);
+
 /**
  * @brief Saves the current state of the canvas.
  *
@@ -1793,6 +2116,26 @@ PLUTOVG_API void plutovg_canvas_set_operator(plutovg_canvas_t* canvas, plutovg_o
  */
 PLUTOVG_API plutovg_operator_t plutovg_canvas_get_operator(const plutovg_canvas_t* canvas);
 
+/**
+ * @brief Sets the filter used to sample texture paints.
+ *
+ * The filter applies only when the texture is scaled, rotated or skewed; a texture drawn at its
+ * natural size is always copied pixel for pixel.
+ * If not set, the default texture filter is `PLUTOVG_TEXTURE_FILTER_NEAREST`.
+ *
+ * @param canvas A pointer to a `plutovg_canvas_t` object.
+ * @param filter The texture filter.
+ */
+PLUTOVG_API void plutovg_canvas_set_texture_filter(plutovg_canvas_t* canvas, plutovg_texture_filter_t filter);
+
+/**
+ * @brief Retrieves the current texture filter.
+ *
+ * @param canvas A pointer to a `plutovg_canvas_t` object.
+ * @return The current texture filter.
+ */
+PLUTOVG_API plutovg_texture_filter_t plutovg_canvas_get_texture_filter(const plutovg_canvas_t* canvas);
+
 /**
  * @brief Sets the global opacity.
  *
@@ -2493,6 +2836,31 @@ PLUTOVG_API float plutovg_canvas_fill_text(plutovg_canvas_t* canvas, const void*
  */
 PLUTOVG_API float plutovg_canvas_stroke_text(plutovg_canvas_t* canvas, const void* text, int length, plutovg_text_encoding_t encoding, float x, float y);
 
+/**
+ * @brief Fills several text runs as a single shape.
+ *
+ * The runs are rasterized and blended in one pass, which is cheaper than filling each run
+ * separately when they share the same paint, font and transformation.
+ *
+ * @note The current path will be cleared by this operation.
+ * @param canvas A pointer to a `plutovg_canvas_t` object.
+ * @param runs An array of `plutovg_text_run_t` objects.
+ * @param count The number of runs in the array.
+ * @param encoding The encoding of the text data.
+ */
+PLUTOVG_API void plutovg_canvas_fill_text_runs(plutovg_canvas_t* canvas, const plutovg_text_run_t* runs, int count, plutovg_text_encoding_t encoding);
+
+/**
+ * @brief Strokes several text runs as a single shape.
+ *
+ * @note The current path will be cleared by this operation.
+ * @param canvas A pointer to a `plutovg_canvas_t` object.
+ * @param runs An array of `plutovg_text_run_t` objects.
+ * @param count The number of runs in the array.
+ * @param encoding The encoding of the text data.
+ */
+PLUTOVG_API void plutovg_canvas_stroke_text_runs(plutovg_canvas_t* canvas, const plutovg_text_run_t* runs, int count, plutovg_text_encoding_t encoding);
+
 /**
  * @brief Intersects the current clipping region with text at the specified origin.
  *
@@ -4,32 +4,6 @@
 #include <assert.h>
 #include <limits.h>
 
-#define COLOR_TABLE_SIZE 1024
-typedef struct {
-    plutovg_matrix_t matrix;
-    plutovg_spread_method_t spread;
-    uint32_t colortable[COLOR_TABLE_SIZE];
-    union {
-        struct {
-            float x1, y1;
-            float x2, y2;
-        } linear;
-        struct {
-            float cx, cy, cr;
-            float fx, fy, fr;
-        } radial;
-    } values;
-} gradient_data_t;
-
-typedef struct {
-    plutovg_matrix_t matrix;
-    uint8_t* data;
-    int width;
-    int height;
-    int stride;
-    int const_alpha;
-} texture_data_t;
-
 typedef struct {
     float dx;
     float dy;
@@ -147,21 +121,57 @@ void plutovg_memfill32(unsigned int* dest, int length, unsigned int value)
 
 #endif // __SSE2__
 
-static inline int gradient_clamp(const gradient_data_t* gradient, int ipos)
+#ifdef __SSE2__
+
+static inline uint32_t interpolate_4_pixels(uint32_t tl, uint32_t tr, uint32_t bl, uint32_t br, uint32_t distx, uint32_t disty)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i top = _mm_unpacklo_epi8(_mm_set_epi32(0, 0, tr, tl), zero);
+    __m128i bottom = _mm_unpacklo_epi8(_mm_set_epi32(0, 0, br, bl), zero);
+    __m128i vdisty = _mm_set1_epi16(disty);
+    __m128i vidisty = _mm_set1_epi16(256 - disty);
+    __m128i column = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(top, vidisty), _mm_mullo_epi16(bottom, vdisty)), 8);
+    __m128i vdistx = _mm_set_epi16(distx, distx, distx, distx, 256 - distx, 256 - distx, 256 - distx, 256 - distx);
+    column = _mm_mullo_epi16(column, vdistx);
+    column = _mm_srli_epi16(_mm_add_epi16(column, _mm_srli_si128(column, 8)), 8);
+    return _mm_cvtsi128_si32(_mm_packus_epi16(column, column));
+}
+
+#else
+
+static inline uint32_t INTERPOLATE_PIXEL_256(uint32_t x, uint32_t a, uint32_t y, uint32_t b)
+{
+    uint32_t t = (x & 0xff00ff) * a + (y & 0xff00ff) * b;
+    t = (t >> 8) & 0xff00ff;
+    x = ((x >> 8) & 0xff00ff) * a + ((y >> 8) & 0xff00ff) * b;
+    x &= 0xff00ff00;
+    return x | t;
+}
+
+static inline uint32_t interpolate_4_pixels(uint32_t tl, uint32_t tr, uint32_t bl, uint32_t br, uint32_t distx, uint32_t disty)
+{
+    uint32_t left = INTERPOLATE_PIXEL_256(tl, 256 - disty, bl, disty);
+    uint32_t right = INTERPOLATE_PIXEL_256(tr, 256 - disty, br, disty);
+    return INTERPOLATE_PIXEL_256(left, 256 - distx, right, distx);
+}
+
+#endif // __SSE2__
+
+static inline int gradient_clamp(const plutovg_gradient_data_t* gradient, int ipos)
 {
     if(gradient->spread == PLUTOVG_SPREAD_METHOD_REPEAT) {
-        ipos = ipos % COLOR_TABLE_SIZE;
-        ipos = ipos < 0 ? COLOR_TABLE_SIZE + ipos : ipos;
+        ipos = ipos % PLUTOVG_COLOR_TABLE_SIZE;
+        ipos = ipos < 0 ? PLUTOVG_COLOR_TABLE_SIZE + ipos : ipos;
     } else if(gradient->spread == PLUTOVG_SPREAD_METHOD_REFLECT) {
-        const int limit = COLOR_TABLE_SIZE * 2;
+        const int limit = PLUTOVG_COLOR_TABLE_SIZE * 2;
         ipos = ipos % limit;
         ipos = ipos < 0 ? limit + ipos : ipos;
-        ipos = ipos >= COLOR_TABLE_SIZE ? limit - 1 - ipos : ipos;
+        ipos = ipos >= PLUTOVG_COLOR_TABLE_SIZE ? limit - 1 - ipos : ipos;
     } else {
         if(ipos < 0) {
             ipos = 0;
-        } else if(ipos >= COLOR_TABLE_SIZE) {
-            ipos = COLOR_TABLE_SIZE - 1;
+        } else if(ipos >= PLUTOVG_COLOR_TABLE_SIZE) {
+            ipos = PLUTOVG_COLOR_TABLE_SIZE - 1;
         }
     }
 
@@ -170,19 +180,86 @@ static inline int gradient_clamp(const gradient_data_t* gradient, int ipos)
 
 #define FIXPT_BITS 8
 #define FIXPT_SIZE (1 << FIXPT_BITS)
-static inline uint32_t gradient_pixel_fixed(const gradient_data_t* gradient, int fixed_pos)
+static inline uint32_t gradient_pixel_fixed(const plutovg_gradient_data_t* gradient, int fixed_pos)
 {
     int ipos = (fixed_pos + (FIXPT_SIZE / 2)) >> FIXPT_BITS;
     return gradient->colortable[gradient_clamp(gradient, ipos)];
 }
 
-static inline uint32_t gradient_pixel(const gradient_data_t* gradient, float pos)
+static inline uint32_t gradient_pixel(const plutovg_gradient_data_t* gradient, float pos)
 {
-    int ipos = (int)(pos * (COLOR_TABLE_SIZE - 1) + 0.5f);
+    int ipos = (int)(pos * (PLUTOVG_COLOR_TABLE_SIZE - 1) + 0.5f);
     return gradient->colortable[gradient_clamp(gradient, ipos)];
 }
 
-static void fetch_linear_gradient(uint32_t* buffer, const linear_gradient_values_t* v, const gradient_data_t* gradient, int y, int x, int length)
+#ifdef __SSE2__
+
+/*
+ * Vector form of gradient_clamp(). The color table size is a power of two, so
+ * the modulo of the repeat and reflect spreads is a mask, negative positions
+ * included.
+ */
+static inline __m128i gradient_clamp_sse2(const plutovg_gradient_data_t* gradient, __m128i ipos)
+{
+    const __m128i limit = _mm_set1_epi32(PLUTOVG_COLOR_TABLE_SIZE - 1);
+    if(gradient->spread == PLUTOVG_SPREAD_METHOD_REPEAT)
+        return _mm_and_si128(ipos, limit);
+    if(gradient->spread == PLUTOVG_SPREAD_METHOD_REFLECT) {
+        const __m128i period = _mm_set1_epi32(PLUTOVG_COLOR_TABLE_SIZE * 2 - 1);
+        ipos = _mm_and_si128(ipos, period);
+        __m128i reflected = _mm_cmpgt_epi32(ipos, limit);
+        return _mm_or_si128(_mm_and_si128(reflected, _mm_sub_epi32(period, ipos)), _mm_andnot_si128(reflected, ipos));
+    }
+
+    ipos = _mm_and_si128(ipos, _mm_cmpgt_epi32(ipos, _mm_set1_epi32(-1)));
+    __m128i above = _mm_cmpgt_epi32(ipos, limit);
+    return _mm_or_si128(_mm_and_si128(above, limit), _mm_andnot_si128(above, ipos));
+}
+
+static inline void gradient_store_sse2(uint32_t* buffer, const plutovg_gradient_data_t* gradient, __m128i ipos)
+{
+    int index[4];
+    _mm_storeu_si128((__m128i*)index, gradient_clamp_sse2(gradient, ipos));
+    buffer[0] = gradient->colortable[index[0]];
+    buffer[1] = gradient->colortable[index[1]];
+    buffer[2] = gradient->colortable[index[2]];
+    buffer[3] = gradient->colortable[index[3]];
+}
+
+static void gradient_fetch_fixed(uint32_t* buffer, const plutovg_gradient_data_t* gradient, int t_fixed, int inc_fixed, int length)
+{
+    const uint32_t* end = buffer + length;
+    if(length >= 4) {
+        __m128i t = _mm_add_epi32(_mm_set1_epi32(t_fixed + FIXPT_SIZE / 2), _mm_setr_epi32(0, inc_fixed, inc_fixed * 2, inc_fixed * 3));
+        const __m128i inc = _mm_set1_epi32(inc_fixed * 4);
+        while(end - buffer >= 4) {
+            gradient_store_sse2(buffer, gradient, _mm_srai_epi32(t, FIXPT_BITS));
+            t = _mm_add_epi32(t, inc);
+            t_fixed += inc_fixed * 4;
+            buffer += 4;
+        }
+    }
+
+    while(buffer < end) {
+        *buffer++ = gradient_pixel_fixed(gradient, t_fixed);
+        t_fixed += inc_fixed;
+    }
+}
+
+#else
+
+static void gradient_fetch_fixed(uint32_t* buffer, const plutovg_gradient_data_t* gradient, int t_fixed, int inc_fixed, int length)
+{
+    const uint32_t* end = buffer + length;
+    while(buffer < end) {
+        *buffer++ = gradient_pixel_fixed(gradient, t_fixed);
+        t_fixed += inc_fixed;
+    }
+}
+
+#endif // __SSE2__
+
+static void fetch_linear_gradient(uint32_t* buffer, const linear_gradient_values_t* v, const plutovg_gradient_data_t* gradient, int y, int x, int length)
 {
     float t, inc;
     float rx = 0, ry = 0;
@@ -194,8 +271,8 @@ static void fetch_linear_gradient(uint32_t* buffer, const linear_gradient_values
         ry = gradient->matrix.d * (y + 0.5f) + gradient->matrix.b * (x + 0.5f) + gradient->matrix.f;
         t = v->dx * rx + v->dy * ry + v->off;
         inc = v->dx * gradient->matrix.a + v->dy * gradient->matrix.b;
-        t *= (COLOR_TABLE_SIZE - 1);
-        inc *= (COLOR_TABLE_SIZE - 1);
+        t *= (PLUTOVG_COLOR_TABLE_SIZE - 1);
+        inc *= (PLUTOVG_COLOR_TABLE_SIZE - 1);
     }
 
     const uint32_t* end = buffer + length;
@@ -203,16 +280,10 @@ static void fetch_linear_gradient(uint32_t* buffer, const linear_gradient_values
         plutovg_memfill32(buffer, length, gradient_pixel_fixed(gradient, (int)(t * FIXPT_SIZE)));
     } else {
         if(t + inc * length < (float)(INT_MAX >> (FIXPT_BITS + 1)) && t + inc * length > (float)(INT_MIN >> (FIXPT_BITS + 1))) {
-            int t_fixed = (int)(t * FIXPT_SIZE);
-            int inc_fixed = (int)(inc * FIXPT_SIZE);
-            while(buffer < end) {
-                *buffer = gradient_pixel_fixed(gradient, t_fixed);
-                t_fixed += inc_fixed;
-                ++buffer;
-            }
+            gradient_fetch_fixed(buffer, gradient, (int)(t * FIXPT_SIZE), (int)(inc * FIXPT_SIZE), length);
         } else {
             while(buffer < end) {
-                *buffer = gradient_pixel(gradient, t / COLOR_TABLE_SIZE);
+                *buffer = gradient_pixel(gradient, t / PLUTOVG_COLOR_TABLE_SIZE);
                 t += inc;
                 ++buffer;
             }
@@ -220,7 +291,7 @@ static void fetch_linear_gradient(uint32_t* buffer, const linear_gradient_values
     }
 }
 
-static void fetch_radial_gradient(uint32_t* buffer, const radial_gradient_values_t* v, const gradient_data_t* gradient, int y, int x, int length)
+static void fetch_radial_gradient(uint32_t* buffer, const radial_gradient_values_t* v, const plutovg_gradient_data_t* gradient, int y, int x, int length)
 {
     if(v->a == 0.f) {
         plutovg_memfill32(buffer, length, 0);
@@ -260,6 +331,48 @@ static void fetch_radial_gradient(uint32_t* buffer, const radial_gradient_values
     float delta_delta_det = (delta_b_delta_b + 4 * v->a * delta_rx_plus_ry) * inv_a;
 
     const uint32_t* end = buffer + length;
+#ifdef __SSE2__
+    /*
+     * det and b are quadratic and linear in the pixel index, so four pixels
+     * at a time evaluate them directly instead of accumulating differences.
+     */
+    const float half_delta_delta_det = delta_delta_det * 0.5f;
+    const __m128 vdet = _mm_set1_ps(det);
+    const __m128 vdelta_det = _mm_set1_ps(delta_det - half_delta_delta_det);
+    const __m128 vhalf_delta_delta_det = _mm_set1_ps(half_delta_delta_det);
+    const __m128 vb = _mm_set1_ps(b);
+    const __m128 vdelta_b = _mm_set1_ps(delta_b);
+    const __m128 vfr = _mm_set1_ps(gradient->values.radial.fr);
+    const __m128 vdr = _mm_set1_ps(v->dr);
+    const __m128 vscale = _mm_set1_ps(PLUTOVG_COLOR_TABLE_SIZE - 1);
+    const __m128 vhalf = _mm_set1_ps(0.5f);
+    const __m128 vzero = _mm_setzero_ps();
+    __m128 index = _mm_setr_ps(0.f, 1.f, 2.f, 3.f);
+    while(buffer < end) {
+        __m128 d = _mm_add_ps(vdet, _mm_mul_ps(index, _mm_add_ps(vdelta_det, _mm_mul_ps(index, vhalf_delta_delta_det))));
+        __m128 w = _mm_sub_ps(_mm_sqrt_ps(d), _mm_add_ps(vb, _mm_mul_ps(index, vdelta_b)));
+
+        uint32_t pixels[4];
+        gradient_store_sse2(pixels, gradient, _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(w, vscale), vhalf)));
+        __m128i result = _mm_loadu_si128((const __m128i*)pixels);
+        if(v->extended) {
+            __m128 mask = _mm_and_ps(_mm_cmpge_ps(d, vzero), _mm_cmpge_ps(_mm_add_ps(vfr, _mm_mul_ps(vdr, w)), vzero));
+            result = _mm_and_si128(result, _mm_castps_si128(mask));
+        }
+
+        if(end - buffer >= 4) {
+            _mm_storeu_si128((__m128i*)buffer, result);
+            buffer += 4;
+        } else {
+            _mm_storeu_si128((__m128i*)pixels, result);
+            for(int i = 0; buffer < end; i++) {
+                *buffer++ = pixels[i];
+            }
+        }
+
+        index = _mm_add_ps(index, _mm_set1_ps(4.f));
+    }
+#else
     if(v->extended) {
         while(buffer < end) {
             uint32_t result = 0;
@@ -284,6 +397,7 @@ static void fetch_radial_gradient(uint32_t* buffer, const radial_gradient_values
             b += delta_b;
         }
     }
+#endif // __SSE2__
 }
 
 static void composition_solid_clear(uint32_t* dest, int length, uint32_t color, uint32_t const_alpha)
@@ -635,11 +749,11 @@ static const composition_function_t composition_table[] = {
     composition_xor
 };
 
-static void blend_solid(plutovg_surface_t* surface, plutovg_operator_t op, uint32_t solid, const plutovg_span_buffer_t* span_buffer)
+static void blend_solid(const plutovg_blender_t* blender, const plutovg_span_t* spans, int count)
 {
-    composition_solid_function_t func = composition_solid_table[op];
-    int count = span_buffer->spans.size;
-    const plutovg_span_t* spans = span_buffer->spans.data;
+    plutovg_surface_t* surface = blender->surface;
+    const uint32_t solid = blender->solid;
+    composition_solid_function_t func = composition_solid_table[blender->op];
     while(count--) {
         uint32_t* target = (uint32_t*)(surface->data + spans->y * surface->stride) + spans->x;
         func(target, spans->len, solid, spans->coverage);
@@ -647,10 +761,38 @@ static void blend_solid(plutovg_surface_t* surface, plutovg_operator_t op, uint3
     }
 }
 
+static void blend_solid_source(const plutovg_blender_t* blender, const plutovg_span_t* spans, int count)
+{
+    plutovg_surface_t* surface = blender->surface;
+    const uint32_t solid = blender->solid;
+    const plutovg_span_t* end = spans + count;
+    while(spans < end) {
+        uint32_t* target = (uint32_t*)(surface->data + spans->y * surface->stride) + spans->x;
+        if(spans->coverage < 255) {
+            composition_solid_source(target, spans->len, solid, spans->coverage);
+            ++spans;
+            continue;
+        }
+
+        /* Full coverage replaces the pixels; abutting runs on the row become one fill. */
+        int length = spans->len;
+        const plutovg_span_t* next = spans + 1;
+        while(next < end && next->y == spans->y && next->x == spans->x + length && next->coverage == 255) {
+            length += next->len;
+            ++next;
+        }
+
+        plutovg_memfill32(target, length, solid);
+        spans = next;
+    }
+}
+
 #define BUFFER_SIZE 1024
-static void blend_linear_gradient(plutovg_surface_t* surface, plutovg_operator_t op, const gradient_data_t* gradient, const plutovg_span_buffer_t* span_buffer)
+static void blend_linear_gradient(const plutovg_blender_t* blender, const plutovg_span_t* spans, int count)
 {
-    composition_function_t func = composition_table[op];
+    plutovg_surface_t* surface = blender->surface;
+    const plutovg_gradient_data_t* gradient = &blender->gradient;
+    composition_function_t func = composition_table[blender->op];
     unsigned int buffer[BUFFER_SIZE];
 
     linear_gradient_values_t v;
@@ -664,8 +806,43 @@ static void blend_linear_gradient(plutovg_surface_t* surface, plutovg_operator_t
         v.off = -v.dx * gradient->values.linear.x1 - v.dy * gradient->values.linear.y1;
     }
 
-    int count = span_buffer->spans.size;
-    const plutovg_span_t* spans = span_buffer->spans.data;
+    float inc_x = (v.dx * gradient->matrix.a + v.dy * gradient->matrix.b) * (PLUTOVG_COLOR_TABLE_SIZE - 1);
+    float inc_y = (v.dx * gradient->matrix.c + v.dy * gradient->matrix.d) * (PLUTOVG_COLOR_TABLE_SIZE - 1);
+    if(v.l == 0.f || (inc_x > -1e-5f && inc_x < 1e-5f)) {
+        /* The color is constant along each row, so every span is a solid fill. */
+        composition_solid_function_t solid_func = composition_solid_table[blender->op];
+        while(count--) {
+            uint32_t color;
+            fetch_linear_gradient(&color, &v, gradient, spans->y, spans->x, 1);
+            uint32_t* target = (uint32_t*)(surface->data + spans->y * surface->stride) + spans->x;
+            solid_func(target, spans->len, color, spans->coverage);
+            ++spans;
+        }
+
+        return;
+    }
+
+    if(inc_y == 0.f) {
+        /* The color depends on x alone, so one row of colors serves every span of the batch. */
+        int x1 = INT_MAX;
+        int x2 = INT_MIN;
+        for(int i = 0; i < count; i++) {
+            x1 = plutovg_min(x1, spans[i].x);
+            x2 = plutovg_max(x2, spans[i].x + spans[i].len);
+        }
+
+        if(x2 - x1 <= BUFFER_SIZE) {
+            fetch_linear_gradient(buffer, &v, gradient, spans->y, x1, x2 - x1);
+            while(count--) {
+                uint32_t* target = (uint32_t*)(surface->data + spans->y * surface->stride) + spans->x;
+                func(target, spans->len, buffer + spans->x - x1, spans->coverage);
+                ++spans;
+            }
+
+            return;
+        }
+    }
+
     while(count--) {
         int length = spans->len;
         int x = spans->x;
@@ -682,9 +859,11 @@ static void blend_linear_gradient(plutovg_surface_t* surface, plutovg_operator_t
     }
 }
 
-static void blend_radial_gradient(plutovg_surface_t* surface, plutovg_operator_t op, const gradient_data_t* gradient, const plutovg_span_buffer_t* span_buffer)
+static void blend_radial_gradient(const plutovg_blender_t* blender, const plutovg_span_t* spans, int count)
 {
-    composition_function_t func = composition_table[op];
+    plutovg_surface_t* surface = blender->surface;
+    const plutovg_gradient_data_t* gradient = &blender->gradient;
+    composition_function_t func = composition_table[blender->op];
     unsigned int buffer[BUFFER_SIZE];
 
     radial_gradient_values_t v;
@@ -695,8 +874,6 @@ static void blend_radial_gradient(plutovg_surface_t* surface, plutovg_operator_t
     v.a = v.dr * v.dr - v.dx * v.dx - v.dy * v.dy;
     v.extended = gradient->values.radial.fr != 0.f || v.a <= 0.f;
 
-    int count = span_buffer->spans.size;
-    const plutovg_span_t* spans = span_buffer->spans.data;
     while(count--) {
         int length = spans->len;
         int x = spans->x;
@@ -713,9 +890,11 @@ static void blend_radial_gradient(plutovg_surface_t* surface, plutovg_operator_t
     }
 }
 
-static void blend_untransformed_argb(plutovg_surface_t* surface, plutovg_operator_t op, const texture_data_t* texture, const plutovg_span_buffer_t* span_buffer)
+static void blend_untransformed_argb(const plutovg_blender_t* blender, const plutovg_span_t* spans, int count)
 {
-    composition_function_t func = composition_table[op];
+    plutovg_surface_t* surface = blender->surface;
+    const plutovg_texture_data_t* texture = &blender->texture;
+    composition_function_t func = composition_table[blender->op];
 
     const int image_width = texture->width;
     const int image_height = texture->height;
@@ -723,8 +902,6 @@ static void blend_untransformed_argb(plutovg_surface_t* surface, plutovg_operato
     int xoff = (int)(texture->matrix.e);
     int yoff = (int)(texture->matrix.f);
 
-    int count = span_buffer->spans.size;
-    const plutovg_span_t* spans = span_buffer->spans.data;
     while(count--) {
         int x = spans->x;
         int length = spans->len;
@@ -752,9 +929,11 @@ static void blend_untransformed_argb(plutovg_surface_t* surface, plutovg_operato
 }
 
 #define FIXED_SCALE (1 << 16)
-static void blend_transformed_argb(plutovg_surface_t* surface, plutovg_operator_t op, const texture_data_t* texture, const plutovg_span_buffer_t* span_buffer)
+static void blend_transformed_argb(const plutovg_blender_t* blender, const plutovg_span_t* spans, int count)
 {
-    composition_function_t func = composition_table[op];
+    plutovg_surface_t* surface = blender->surface;
+    const plutovg_texture_data_t* texture = &blender->texture;
+    composition_function_t func = composition_table[blender->op];
     uint32_t buffer[BUFFER_SIZE];
 
     int image_width = texture->width;
@@ -763,8 +942,6 @@ static void blend_transformed_argb(plutovg_surface_t* surface, plutovg_operator_
     int fdx = (int)(texture->matrix.a * FIXED_SCALE);
     int fdy = (int)(texture->matrix.b * FIXED_SCALE);
 
-    int count = span_buffer->spans.size;
-    const plutovg_span_t* spans = span_buffer->spans.data;
     while(count--) {
         uint32_t* target = (uint32_t*)(surface->data + spans->y * surface->stride) + spans->x;
 
@@ -803,9 +980,11 @@ static void blend_transformed_argb(plutovg_surface_t* surface, plutovg_operator_
     }
 }
 
-static void blend_untransformed_tiled_argb(plutovg_surface_t* surface, plutovg_operator_t op, const texture_data_t* texture, const plutovg_span_buffer_t* span_buffer)
+static void blend_untransformed_tiled_argb(const plutovg_blender_t* blender, const plutovg_span_t* spans, int count)
 {
-    composition_function_t func = composition_table[op];
+    plutovg_surface_t* surface = blender->surface;
+    const plutovg_texture_data_t* texture = &blender->texture;
+    composition_function_t func = composition_table[blender->op];
 
     int image_width = texture->width;
     int image_height = texture->height;
@@ -819,8 +998,6 @@ static void blend_untransformed_tiled_argb(plutovg_surface_t* surface, plutovg_o
         yoff += image_height;
     }
 
-    int count = span_buffer->spans.size;
-    const plutovg_span_t* spans = span_buffer->spans.data;
     while(count--) {
         int x = spans->x;
         int length = spans->len;
@@ -852,9 +1029,11 @@ static void blend_untransformed_tiled_argb(plutovg_surface_t* surface, plutovg_o
     }
 }
 
-static void blend_transformed_tiled_argb(plutovg_surface_t* surface, plutovg_operator_t op, const texture_data_t* texture, const plutovg_span_buffer_t* span_buffer)
+static void blend_transformed_tiled_argb(const plutovg_blender_t* blender, const plutovg_span_t* spans, int count)
 {
-    composition_function_t func = composition_table[op];
+    plutovg_surface_t* surface = blender->surface;
+    const plutovg_texture_data_t* texture = &blender->texture;
+    composition_function_t func = composition_table[blender->op];
     uint32_t buffer[BUFFER_SIZE];
 
     int image_width = texture->width;
@@ -864,8 +1043,6 @@ static void blend_transformed_tiled_argb(plutovg_surface_t* surface, plutovg_ope
     int fdx = (int)(texture->matrix.a * FIXED_SCALE);
     int fdy = (int)(texture->matrix.b * FIXED_SCALE);
 
-    int count = span_buffer->spans.size;
-    const plutovg_span_t* spans = span_buffer->spans.data;
     while(count--) {
         uint32_t* target = (uint32_t*)(surface->data + spans->y * surface->stride) + spans->x;
         const uint32_t* image_bits = (const uint32_t*)texture->data;
@@ -909,30 +1086,146 @@ static void blend_transformed_tiled_argb(plutovg_surface_t* surface, plutovg_ope
     }
 }
 
-static void plutovg_blend_color(plutovg_canvas_t* canvas, const plutovg_color_t* color, const plutovg_span_buffer_t* span_buffer)
+#define FIXED_HALF (FIXED_SCALE / 2)
+static void blend_transformed_bilinear_argb(const plutovg_blender_t* blender, const plutovg_span_t* spans, int count)
+{
+    plutovg_surface_t* surface = blender->surface;
+    const plutovg_texture_data_t* texture = &blender->texture;
+    composition_function_t func = composition_table[blender->op];
+    uint32_t buffer[BUFFER_SIZE];
+
+    int image_width = texture->width;
+    int image_height = texture->height;
+
+    int fdx = (int)(texture->matrix.a * FIXED_SCALE);
+    int fdy = (int)(texture->matrix.b * FIXED_SCALE);
+
+    while(count--) {
+        uint32_t* target = (uint32_t*)(surface->data + spans->y * surface->stride) + spans->x;
+
+        const float cx = spans->x + 0.5f;
+        const float cy = spans->y + 0.5f;
+
+        int x = (int)((texture->matrix.c * cy + texture->matrix.a * cx + texture->matrix.e) * FIXED_SCALE);
+        int y = (int)((texture->matrix.d * cy + texture->matrix.b * cx + texture->matrix.f) * FIXED_SCALE);
+
+        int length = spans->len;
+        const int coverage = (spans->coverage * texture->const_alpha) >> 8;
+        while(length) {
+            int l = plutovg_min(length, BUFFER_SIZE);
+            const uint32_t* end = buffer + l;
+            uint32_t* b = buffer;
+            while(b < end) {
+                int px = x >> 16;
+                int py = y >> 16;
+                if((px < 0) || (px >= image_width) || (py < 0) || (py >= image_height)) {
+                    *b = 0x00000000;
+                } else {
+                    int fx = x - FIXED_HALF;
+                    int fy = y - FIXED_HALF;
+                    int x1 = plutovg_max(fx >> 16, 0);
+                    int y1 = plutovg_max(fy >> 16, 0);
+                    int x2 = plutovg_min((fx >> 16) + 1, image_width - 1);
+                    int y2 = plutovg_min((fy >> 16) + 1, image_height - 1);
+                    const uint32_t* s1 = (const uint32_t*)(texture->data + y1 * texture->stride);
+                    const uint32_t* s2 = (const uint32_t*)(texture->data + y2 * texture->stride);
+                    *b = interpolate_4_pixels(s1[x1], s1[x2], s2[x1], s2[x2], (fx >> 8) & 0xff, (fy >> 8) & 0xff);
+                }
+
+                x += fdx;
+                y += fdy;
+                ++b;
+            }
+
+            func(target, l, buffer, coverage);
+            target += l;
+            length -= l;
+        }
+
+        ++spans;
+    }
+}
+
+static void blend_transformed_tiled_bilinear_argb(const plutovg_blender_t* blender, const plutovg_span_t* spans, int count)
+{
+    plutovg_surface_t* surface = blender->surface;
+    const plutovg_texture_data_t* texture = &blender->texture;
+    composition_function_t func = composition_table[blender->op];
+    uint32_t buffer[BUFFER_SIZE];
+
+    int image_width = texture->width;
+    int image_height = texture->height;
+
+    int fdx = (int)(texture->matrix.a * FIXED_SCALE);
+    int fdy = (int)(texture->matrix.b * FIXED_SCALE);
+
+    while(count--) {
+        uint32_t* target = (uint32_t*)(surface->data + spans->y * surface->stride) + spans->x;
+
+        const float cx = spans->x + 0.5f;
+        const float cy = spans->y + 0.5f;
+
+        int x = (int)((texture->matrix.c * cy + texture->matrix.a * cx + texture->matrix.e) * FIXED_SCALE) - FIXED_HALF;
+        int y = (int)((texture->matrix.d * cy + texture->matrix.b * cx + texture->matrix.f) * FIXED_SCALE) - FIXED_HALF;
+
+        const int coverage = (spans->coverage * texture->const_alpha) >> 8;
+        int length = spans->len;
+        while(length) {
+            int l = plutovg_min(length, BUFFER_SIZE);
+            const uint32_t* end = buffer + l;
+            uint32_t* b = buffer;
+            while(b < end) {
+                int x1 = (x >> 16) % image_width;
+                int y1 = (y >> 16) % image_height;
+                if(x1 < 0) x1 += image_width;
+                if(y1 < 0) y1 += image_height;
+                int x2 = x1 + 1 == image_width ? 0 : x1 + 1;
+                int y2 = y1 + 1 == image_height ? 0 : y1 + 1;
+
+                const uint32_t* s1 = (const uint32_t*)(texture->data + y1 * texture->stride);
+                const uint32_t* s2 = (const uint32_t*)(texture->data + y2 * texture->stride);
+                *b = interpolate_4_pixels(s1[x1], s1[x2], s2[x1], s2[x2], (x >> 8) & 0xff, (y >> 8) & 0xff);
+                x += fdx;
+                y += fdy;
+                ++b;
+            }
+
+            func(target, l, buffer, coverage);
+            target += l;
+            length -= l;
+        }
+
+        ++spans;
+    }
+}
+
+static bool plutovg_blender_init_color(plutovg_blender_t* blender, const plutovg_state_t* state, const plutovg_color_t* color)
 {
-    plutovg_state_t* state = canvas->state;
     uint32_t solid = premultiply_color_with_opacity(color, state->opacity);
     uint32_t alpha = plutovg_alpha(solid);
 
-    if(alpha == 255 && state->op == PLUTOVG_OPERATOR_SRC_OVER) {
-        blend_solid(canvas->surface, PLUTOVG_OPERATOR_SRC, solid, span_buffer);
+    blender->solid = solid;
+    if(alpha == 255 && state->op == PLUTOVG_OPERATOR_SRC_OVER)
+        blender->op = PLUTOVG_OPERATOR_SRC;
+    if(blender->op == PLUTOVG_OPERATOR_SRC) {
+        blender->func = blend_solid_source;
     } else {
-        blend_solid(canvas->surface, state->op, solid, span_buffer);
+        blender->func = blend_solid;
     }
+
+    return true;
 }
 
-static void plutovg_blend_gradient(plutovg_canvas_t* canvas, const plutovg_gradient_paint_t* gradient, const plutovg_span_buffer_t* span_buffer)
+static bool plutovg_blender_init_gradient(plutovg_blender_t* blender, const plutovg_state_t* state, const plutovg_gradient_paint_t* gradient)
 {
     if(gradient->nstops == 0)
-        return;
-    plutovg_state_t* state = canvas->state;
-    gradient_data_t data;
-    data.spread = gradient->spread;
-    data.matrix = gradient->matrix;
-    plutovg_matrix_multiply(&data.matrix, &data.matrix, &state->matrix);
-    if(!plutovg_matrix_invert(&data.matrix, &data.matrix))
-        return;
+        return false;
+    plutovg_gradient_data_t* data = &blender->gradient;
+    data->spread = gradient->spread;
+    data->matrix = gradient->matrix;
+    plutovg_matrix_multiply(&data->matrix, &data->matrix, &state->matrix);
+    if(!plutovg_matrix_invert(&data->matrix, &data->matrix))
+        return false;
     int i, pos = 0, nstops = gradient->nstops;
     const plutovg_gradient_stop_t *curr, *next, *start, *last;
     uint32_t curr_color, next_color, last_color;
@@ -944,12 +1237,12 @@ static void plutovg_blend_gradient(plutovg_canvas_t* canvas, const plutovg_gradi
     curr = start;
     curr_color = premultiply_color_with_opacity(&curr->color, opacity);
 
-    data.colortable[pos++] = curr_color;
-    incr = 1.0f / COLOR_TABLE_SIZE;
+    data->colortable[pos++] = curr_color;
+    incr = 1.0f / PLUTOVG_COLOR_TABLE_SIZE;
     fpos = 1.5f * incr;
 
     while(fpos <= curr->offset) {
-        data.colortable[pos] = data.colortable[pos - 1];
+        data->colortable[pos] = data->colortable[pos - 1];
         ++pos;
         fpos += incr;
     }
@@ -961,11 +1254,11 @@ static void plutovg_blend_gradient(plutovg_canvas_t* canvas, const plutovg_gradi
             continue;
         delta = 1.f / (next->offset - curr->offset);
         next_color = premultiply_color_with_opacity(&next->color, opacity);
-        while(fpos < next->offset && pos < COLOR_TABLE_SIZE) {
+        while(fpos < next->offset && pos < PLUTOVG_COLOR_TABLE_SIZE) {
             t = (fpos - curr->offset) * delta;
             dist = (uint32_t)(255 * t);
             idist = 255 - dist;
-            data.colortable[pos] = INTERPOLATE_PIXEL(curr_color, idist, next_color, dist);
+            data->colortable[pos] = INTERPOLATE_PIXEL(curr_color, idist, next_color, dist);
             ++pos;
             fpos += incr;
         }
@@ -975,77 +1268,126 @@ static void plutovg_blend_gradient(plutovg_canvas_t* canvas, const plutovg_gradi
 
     last = start + nstops - 1;
     last_color = premultiply_color_with_opacity(&last->color, opacity);
-    for(; pos < COLOR_TABLE_SIZE; ++pos) {
-        data.colortable[pos] = last_color;
+    for(; pos < PLUTOVG_COLOR_TABLE_SIZE; ++pos) {
+        data->colortable[pos] = last_color;
     }
 
     if(gradient->type == PLUTOVG_GRADIENT_TYPE_LINEAR) {
-        data.values.linear.x1 = gradient->values[0];
-        data.values.linear.y1 = gradient->values[1];
-        data.values.linear.x2 = gradient->values[2];
-        data.values.linear.y2 = gradient->values[3];
-        blend_linear_gradient(canvas->surface, state->op, &data, span_buffer);
+        data->values.linear.x1 = gradient->values[0];
+        data->values.linear.y1 = gradient->values[1];
+        data->values.linear.x2 = gradient->values[2];
+        data->values.linear.y2 = gradient->values[3];
+        blender->func = blend_linear_gradient;
     } else {
-        data.values.radial.cx = gradient->values[0];
-        data.values.radial.cy = gradient->values[1];
-        data.values.radial.cr = gradient->values[2];
-        data.values.radial.fx = gradient->values[3];
-        data.values.radial.fy = gradient->values[4];
-        data.values.radial.fr = gradient->values[5];
-        blend_radial_gradient(canvas->surface, state->op, &data, span_buffer);
+        data->values.radial.cx = gradient->values[0];
+        data->values.radial.cy = gradient->values[1];
+        data->values.radial.cr = gradient->values[2];
+        data->values.radial.fx = gradient->values[3];
+        data->values.radial.fy = gradient->values[4];
+        data->values.radial.fr = gradient->values[5];
+        blender->func = blend_radial_gradient;
     }
+
+    return true;
 }
 
-static void plutovg_blend_texture(plutovg_canvas_t* canvas, const plutovg_texture_paint_t* texture, const plutovg_span_buffer_t* span_buffer)
+static bool plutovg_blender_init_texture(plutovg_blender_t* blender, const plutovg_state_t* state, const plutovg_texture_paint_t* texture)
 {
     if(texture->surface == NULL)
-        return;
-    plutovg_state_t* state = canvas->state;
-    texture_data_t data;
-    data.matrix = texture->matrix;
-    data.data = texture->surface->data;
-    data.width = texture->surface->width;
-    data.height = texture->surface->height;
-    data.stride = texture->surface->stride;
-    data.const_alpha = lroundf(state->opacity * texture->opacity * 256);
-
-    plutovg_matrix_multiply(&data.matrix, &data.matrix, &state->matrix);
-    if(!plutovg_matrix_invert(&data.matrix, &data.matrix))
-        return;
-    const plutovg_matrix_t* matrix = &data.matrix;
-    if(matrix->a == 1 && matrix->b == 0 && matrix->c == 0 && matrix->d == 1) {
+        return false;
+    plutovg_texture_data_t* data = &blender->texture;
+    data->matrix = texture->matrix;
+    plutovg_matrix_multiply(&data->matrix, &data->matrix, &state->matrix);
+    if(!plutovg_matrix_invert(&data->matrix, &data->matrix))
+        return false;
+    plutovg_surface_t* surface = texture->surface;
+    const plutovg_matrix_t* matrix = &data->matrix;
+    bool untransformed = matrix->a == 1 && matrix->b == 0 && matrix->c == 0 && matrix->d == 1;
+    bool bilinear = !untransformed && state->filter == PLUTOVG_TEXTURE_FILTER_BILINEAR;
+    if(bilinear) {
+        /* Beyond a 2:1 downscale the bilinear taps skip texels, so sample a smaller mipmap level. */
+        float scale = plutovg_max(sqrtf(matrix->a * matrix->a + matrix->b * matrix->b), sqrtf(matrix->c * matrix->c + matrix->d * matrix->d));
+        plutovg_surface_t* level = surface;
+        while(scale >= 2.f) {
+            plutovg_surface_t* mipmap = plutovg_surface_get_mipmap(level);
+            if(mipmap == NULL)
+                break;
+            level = mipmap;
+            scale *= 0.5f;
+        }
+
+        if(level != surface) {
+            plutovg_matrix_t level_matrix;
+            plutovg_matrix_init_scale(&level_matrix, (float)(level->width) / surface->width, (float)(level->height) / surface->height);
+            plutovg_matrix_multiply(&data->matrix, &data->matrix, &level_matrix);
+            surface = level;
+        }
+    }
+
+    data->data = surface->data;
+    data->width = surface->width;
+    data->height = surface->height;
+    data->stride = surface->stride;
+    data->const_alpha = lroundf(state->opacity * texture->opacity * 256);
+    if(untransformed) {
+        if(texture->type == PLUTOVG_TEXTURE_TYPE_PLAIN) {
+            blender->func = blend_untransformed_argb;
+        } else {
+            blender->func = blend_untransformed_tiled_argb;
+        }
+    } else if(bilinear) {
         if(texture->type == PLUTOVG_TEXTURE_TYPE_PLAIN) {
-            blend_untransformed_argb(canvas->surface, state->op, &data, span_buffer);
+            blender->func = blend_transformed_bilinear_argb;
         } else {
-            blend_untransformed_tiled_argb(canvas->surface, state->op, &data, span_buffer);
+            blender->func = blend_transformed_tiled_bilinear_argb;
         }
     } else {
         if(texture->type == PLUTOVG_TEXTURE_TYPE_PLAIN) {
-            blend_transformed_argb(canvas->surface, state->op, &data, span_buffer);
+            blender->func = blend_transformed_argb;
         } else {
-            blend_transformed_tiled_argb(canvas->surface, state->op, &data, span_buffer);
+            blender->func = blend_transformed_tiled_argb;
         }
     }
+
+    return true;
+}
+
+bool plutovg_blender_init(plutovg_blender_t* blender, plutovg_canvas_t* canvas)
+{
+    const plutovg_state_t* state = canvas->state;
+    plutovg_surface_mark_dirty(canvas->surface);
+    blender->surface = canvas->surface;
+    blender->op = state->op;
+    if(state->paint == NULL)
+        return plutovg_blender_init_color(blender, state, &state->color);
+    const plutovg_paint_t* paint = state->paint;
+    if(paint->type == PLUTOVG_PAINT_TYPE_COLOR) {
+        const plutovg_solid_paint_t* solid = (const plutovg_solid_paint_t*)(paint);
+        return plutovg_blender_init_color(blender, state, &solid->color);
+    }
+
+    if(paint->type == PLUTOVG_PAINT_TYPE_GRADIENT) {
+        const plutovg_gradient_paint_t* gradient = (const plutovg_gradient_paint_t*)(paint);
+        return plutovg_blender_init_gradient(blender, state, gradient);
+    }
+
+    const plutovg_texture_paint_t* texture = (const plutovg_texture_paint_t*)(paint);
+    return plutovg_blender_init_texture(blender, state, texture);
+}
+
+void plutovg_blender_blend(const plutovg_blender_t* blender, const plutovg_span_t* spans, int count)
+{
+    if(count > 0) {
+        blender->func(blender, spans, count);
+    }
 }
 
 void plutovg_blend(plutovg_canvas_t* canvas, const plutovg_span_buffer_t* span_buffer)
 {
     if(span_buffer->spans.size == 0)
         return;
-    if(canvas->state->paint == NULL) {
-        plutovg_blend_color(canvas, &canvas->state->color, span_buffer);
-        return;
-    }
-
-    plutovg_paint_t* paint = canvas->state->paint;
-    if(paint->type == PLUTOVG_PAINT_TYPE_COLOR) {
-        plutovg_solid_paint_t* solid = (plutovg_solid_paint_t*)(paint);
-        plutovg_blend_color(canvas, &solid->color, span_buffer);
-    } else if(paint->type == PLUTOVG_PAINT_TYPE_GRADIENT) {
-        plutovg_gradient_paint_t* gradient = (plutovg_gradient_paint_t*)(paint);
-        plutovg_blend_gradient(canvas, gradient, span_buffer);
-    } else {
-        plutovg_texture_paint_t* texture = (plutovg_texture_paint_t*)(paint);
-        plutovg_blend_texture(canvas, texture, span_buffer);
+    plutovg_blender_t blender;
+    if(plutovg_blender_init(&blender, canvas)) {
+        plutovg_blender_blend(&blender, span_buffer->spans.data, span_buffer->spans.size);
     }
 }
@@ -26,6 +26,7 @@ static plutovg_state_t* plutovg_state_create(void)
     plutovg_span_buffer_init(&state->clip_spans);
     state->winding = PLUTOVG_FILL_RULE_NON_ZERO;
     state->op = PLUTOVG_OPERATOR_SRC_OVER;
+    state->filter = PLUTOVG_TEXTURE_FILTER_NEAREST;
     state->font_size = 12.f;
     state->opacity = 1.f;
     state->clipping = false;
@@ -47,6 +48,7 @@ static void plutovg_state_reset(plutovg_state_t* state)
     plutovg_span_buffer_reset(&state->clip_spans);
     state->winding = PLUTOVG_FILL_RULE_NON_ZERO;
     state->op = PLUTOVG_OPERATOR_SRC_OVER;
+    state->filter = PLUTOVG_TEXTURE_FILTER_NEAREST;
     state->font_size = 12.f;
     state->opacity = 1.f;
     state->clipping = false;
@@ -65,6 +67,7 @@ static void plutovg_state_copy(plutovg_state_t* state, const plutovg_state_t* so
     plutovg_span_buffer_copy(&state->clip_spans, &source->clip_spans);
     state->winding = source->winding;
     state->op = source->op;
+    state->filter = source->filter;
     state->font_size = source->font_size;
     state->opacity = source->opacity;
     state->clipping = source->clipping;
@@ -91,6 +94,11 @@ plutovg_canvas_t* plutovg_canvas_create(plutovg_surface_t* surface)
     canvas->clip_rect = PLUTOVG_MAKE_RECT(0, 0, surface->width, surface->height);
     plutovg_span_buffer_init(&canvas->clip_spans);
     plutovg_span_buffer_init(&canvas->fill_spans);
+    canvas->raster_pool.buffer = NULL;
+    canvas->raster_pool.size = 0;
+    canvas->raster_config.rasterizer = PLUTOVG_RASTERIZER_CELL;
+    canvas->raster_config.flatness = 0.f;
+    canvas->raster_config.glyph_cache = false;
     return canvas;
 }
 
@@ -118,6 +126,7 @@ void plutovg_canvas_destroy(plutovg_canvas_t* canvas)
         plutovg_font_face_cache_destroy(canvas->face_cache);
         plutovg_span_buffer_destroy(&canvas->fill_spans);
         plutovg_span_buffer_destroy(&canvas->clip_spans);
+        free(canvas->raster_pool.buffer);
         plutovg_surface_destroy(canvas->surface);
         plutovg_path_destroy(canvas->path);
         free(canvas);
@@ -134,6 +143,36 @@ plutovg_surface_t* plutovg_canvas_get_surface(const plutovg_canvas_t* canvas)
     return canvas->surface;
 }
 
+void plutovg_canvas_set_rasterizer(plutovg_canvas_t* canvas, plutovg_rasterizer_t rasterizer)
+{
+    canvas->raster_config.rasterizer = rasterizer;
+}
+
+plutovg_rasterizer_t plutovg_canvas_get_rasterizer(const plutovg_canvas_t* canvas)
+{
+    return canvas->raster_config.rasterizer;
+}
+
+void plutovg_canvas_set_flatness(plutovg_canvas_t* canvas, float flatness)
+{
+    canvas->raster_config.flatness = flatness > 0.f ? plutovg_clamp(flatness, 1.f / 64.f, 4.f) : 0.f;
+}
+
+float plutovg_canvas_get_flatness(const plutovg_canvas_t* canvas)
+{
+    return canvas->raster_config.flatness;
+}
+
+void plutovg_canvas_set_glyph_cache(plutovg_canvas_t* canvas, bool enabled)
+{
+    canvas->raster_config.glyph_cache = enabled;
+}
+
+bool plutovg_canvas_get_glyph_cache(const plutovg_canvas_t* canvas)
+{
+    return canvas->raster_config.glyph_cache;
+}
+
 void plutovg_canvas_save(plutovg_canvas_t* canvas)
 {
     plutovg_state_t* new_state = canvas->freed_state;
@@ -293,6 +332,16 @@ plutovg_operator_t plutovg_canvas_get_operator(const plutovg_canvas_t* canvas)
     return canvas->state->op;
 }
 
+void plutovg_canvas_set_texture_filter(plutovg_canvas_t* canvas, plutovg_texture_filter_t filter)
+{
+    canvas->state->filter = filter;
+}
+
+plutovg_texture_filter_t plutovg_canvas_get_texture_filter(const plutovg_canvas_t* canvas)
+{
+    return canvas->state->filter;
+}
+
 void plutovg_canvas_set_opacity(plutovg_canvas_t* canvas, float opacity)
 {
     canvas->state->opacity = plutovg_clamp(opacity, 0.f, 1.f);
@@ -504,13 +553,13 @@ plutovg_path_t* plutovg_canvas_get_path(const plutovg_canvas_t* canvas)
 
 bool plutovg_canvas_fill_contains(plutovg_canvas_t* canvas, float x, float y)
 {
-    plutovg_rasterize(&canvas->fill_spans, canvas->path, &canvas->state->matrix, NULL, NULL, canvas->state->winding);
+    plutovg_rasterize(&canvas->fill_spans, canvas->path, &canvas->state->matrix, NULL, NULL, canvas->state->winding, &canvas->raster_config, &canvas->raster_pool);
     return plutovg_span_buffer_contains(&canvas->fill_spans, x, y);
 }
 
 bool plutovg_canvas_stroke_contains(plutovg_canvas_t* canvas, float x, float y)
 {
-    plutovg_rasterize(&canvas->fill_spans, canvas->path, &canvas->state->matrix, NULL, NULL, canvas->state->winding);
+    plutovg_rasterize(&canvas->fill_spans, canvas->path, &canvas->state->matrix, NULL, NULL, canvas->state->winding, &canvas->raster_config, &canvas->raster_pool);
     return plutovg_span_buffer_contains(&canvas->fill_spans, x, y);
 }
 
@@ -530,13 +579,13 @@ bool plutovg_canvas_clip_contains(plutovg_canvas_t* canvas, float x, float y)
 
 void plutovg_canvas_fill_extents(plutovg_canvas_t *canvas, plutovg_rect_t* extents)
 {
-    plutovg_rasterize(&canvas->fill_spans, canvas->path, &canvas->state->matrix, NULL, NULL, canvas->state->winding);
+    plutovg_rasterize(&canvas->fill_spans, canvas->path, &canvas->state->matrix, NULL, NULL, canvas->state->winding, &canvas->raster_config, &canvas->raster_pool);
     plutovg_span_buffer_extents(&canvas->fill_spans, extents);
 }
 
 void plutovg_canvas_stroke_extents(plutovg_canvas_t *canvas, plutovg_rect_t* extents)
 {
-    plutovg_rasterize(&canvas->fill_spans, canvas->path, &canvas->state->matrix, NULL, &canvas->state->stroke, PLUTOVG_FILL_RULE_NON_ZERO);
+    plutovg_rasterize(&canvas->fill_spans, canvas->path, &canvas->state->matrix, NULL, &canvas->state->stroke, PLUTOVG_FILL_RULE_NON_ZERO, &canvas->raster_config, &canvas->raster_pool);
     plutovg_span_buffer_extents(&canvas->fill_spans, extents);
 }
 
@@ -580,9 +629,8 @@ void plutovg_canvas_paint(plutovg_canvas_t* canvas)
     }
 }
 
-void plutovg_canvas_fill_preserve(plutovg_canvas_t* canvas)
+static void plutovg_canvas_blend_fill_spans(plutovg_canvas_t* canvas)
 {
-    plutovg_rasterize(&canvas->fill_spans, canvas->path, &canvas->state->matrix, &canvas->clip_rect, NULL, canvas->state->winding);
     if(canvas->state->clipping) {
         plutovg_span_buffer_intersect(&canvas->clip_spans, &canvas->fill_spans, &canvas->state->clip_spans);
         plutovg_blend(canvas, &canvas->clip_spans);
@@ -591,25 +639,46 @@ void plutovg_canvas_fill_preserve(plutovg_canvas_t* canvas)
     }
 }
 
-void plutovg_canvas_stroke_preserve(plutovg_canvas_t* canvas)
+static void plutovg_canvas_blend_spans(int count, const plutovg_span_t* spans, void* closure)
+{
+    plutovg_blender_blend((const plutovg_blender_t*)(closure), spans, count);
+}
+
+static void plutovg_canvas_render_path(plutovg_canvas_t* canvas, const plutovg_stroke_data_t* stroke_data, plutovg_fill_rule_t winding)
 {
-    plutovg_rasterize(&canvas->fill_spans, canvas->path, &canvas->state->matrix, &canvas->clip_rect, &canvas->state->stroke, PLUTOVG_FILL_RULE_NON_ZERO);
     if(canvas->state->clipping) {
-        plutovg_span_buffer_intersect(&canvas->clip_spans, &canvas->fill_spans, &canvas->state->clip_spans);
-        plutovg_blend(canvas, &canvas->clip_spans);
-    } else {
-        plutovg_blend(canvas, &canvas->fill_spans);
+        plutovg_rasterize(&canvas->fill_spans, canvas->path, &canvas->state->matrix, &canvas->clip_rect, stroke_data, winding, &canvas->raster_config, &canvas->raster_pool);
+        plutovg_canvas_blend_fill_spans(canvas);
+        return;
+    }
+
+    /* Without a clip mask the spans are blended in batches as the rasterizer emits them. */
+    plutovg_blender_t blender;
+    if(plutovg_blender_init(&blender, canvas)) {
+        plutovg_rasterize_spans(plutovg_canvas_blend_spans, &blender, canvas->path, &canvas->state->matrix, &canvas->clip_rect, stroke_data, winding, &canvas->raster_config, &canvas->raster_pool);
     }
 }
 
+void plutovg_canvas_fill_preserve(plutovg_canvas_t* canvas)
+{
+    plutovg_canvas_render_path(canvas, NULL, canvas->state->winding);
+}
+
+void plutovg_canvas_stroke_preserve(plutovg_canvas_t* canvas)
+{
+    plutovg_canvas_render_path(canvas, &canvas->state->stroke, PLUTOVG_FILL_RULE_NON_ZERO);
+}
+
 void plutovg_canvas_clip_preserve(plutovg_canvas_t* canvas)
 {
     if(canvas->state->clipping) {
-        plutovg_rasterize(&canvas->fill_spans, canvas->path, &canvas->state->matrix, &canvas->clip_rect, NULL, canvas->state->winding);
+        plutovg_rasterize(&canvas->fill_spans, canvas->path, &canvas->state->matrix, &canvas->clip_rect, NULL, canvas->state->winding, &canvas->raster_config, &canvas->raster_pool);
         plutovg_span_buffer_intersect(&canvas->clip_spans, &canvas->fill_spans, &canvas->state->clip_spans);
-        plutovg_span_buffer_copy(&canvas->state->clip_spans, &canvas->clip_spans);
+        plutovg_span_buffer_t clip_spans = canvas->state->clip_spans;
+        canvas->state->clip_spans = canvas->clip_spans;
+        canvas->clip_spans = clip_spans;
     } else {
-        plutovg_rasterize(&canvas->state->clip_spans, canvas->path, &canvas->state->matrix, &canvas->clip_rect, NULL, canvas->state->winding);
+        plutovg_rasterize(&canvas->state->clip_spans, canvas->path, &canvas->state->matrix, &canvas->clip_rect, NULL, canvas->state->winding, &canvas->raster_config, &canvas->raster_pool);
         canvas->state->clipping = true;
     }
 }
@@ -680,12 +749,23 @@ float plutovg_canvas_add_text(plutovg_canvas_t* canvas, const void* text, int le
     return advance_width;
 }
 
+static float plutovg_canvas_fill_text_internal(plutovg_canvas_t* canvas, const plutovg_text_run_t* runs, int count, plutovg_text_encoding_t encoding)
+{
+    plutovg_state_t* state = canvas->state;
+    if(state->font_face == NULL || state->font_size <= 0.f)
+        return 0.f;
+    float advance_width;
+    plutovg_font_face_rasterize_text(state->font_face, state->font_size, &state->matrix, state->winding, &canvas->clip_rect,
+        runs, count, encoding, &canvas->fill_spans, &canvas->raster_config, &canvas->raster_pool, &advance_width);
+    plutovg_canvas_blend_fill_spans(canvas);
+    return advance_width;
+}
+
 float plutovg_canvas_fill_text(plutovg_canvas_t* canvas, const void* text, int length, plutovg_text_encoding_t encoding, float x, float y)
 {
     plutovg_canvas_new_path(canvas);
-    float advance_width = plutovg_canvas_add_text(canvas, text, length, encoding, x, y);
-    plutovg_canvas_fill(canvas);
-    return advance_width;
+    plutovg_text_run_t run = {text, length, x, y};
+    return plutovg_canvas_fill_text_internal(canvas, &run, 1, encoding);
 }
 
 float plutovg_canvas_stroke_text(plutovg_canvas_t* canvas, const void* text, int length, plutovg_text_encoding_t encoding, float x, float y)
@@ -696,6 +776,20 @@ float plutovg_canvas_stroke_text(plutovg_canvas_t* canvas, const void* text, int
     return advance_width;
 }
 
+void plutovg_canvas_fill_text_runs(plutovg_canvas_t* canvas, const plutovg_text_run_t* runs, int count, plutovg_text_encoding_t encoding)
+{
+    plutovg_canvas_new_path(canvas);
+    plutovg_canvas_fill_text_internal(canvas, runs, count, encoding);
+}
+
+void plutovg_canvas_stroke_text_runs(plutovg_canvas_t* canvas, const plutovg_text_run_t* runs, int count, plutovg_text_encoding_t encoding)
+{
+    plutovg_canvas_new_path(canvas);
+    for(int i = 0; i < count; ++i)
+        plutovg_canvas_add_text(canvas, runs[i].text, runs[i].length, encoding, runs[i].x, runs[i].y);
+    plutovg_canvas_stroke(canvas);
+}
+
 float plutovg_canvas_clip_text(plutovg_canvas_t* canvas, const void* text, int length, plutovg_text_encoding_t encoding, float x, float y)
 {
     plutovg_canvas_new_path(canvas);
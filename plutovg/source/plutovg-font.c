@@ -3,6 +3,8 @@
 
 #include <stdio.h>
 #include <assert.h>
+#include <limits.h>
+#include <math.h>
 
 #define STBTT_STATIC
 #define STB_TRUETYPE_IMPLEMENTATION
@@ -143,8 +145,7 @@ typedef int plutovg_mutex_t;
 
 typedef struct plutovg_glyph {
     plutovg_codepoint_t codepoint;
-    stbtt_vertex* vertices;
-    int nvertices;
+    plutovg_outline_t outline;
     int index;
     int advance_width;
     int left_side_bearing;
@@ -156,11 +157,40 @@ typedef struct plutovg_glyph {
 } plutovg_glyph_t;
 
 typedef struct {
-    plutovg_glyph_t** glyphs;
-    size_t size;
+    short x;
+    short len;
+    short y;
+    unsigned char coverage;
+} plutovg_glyph_span_t;
+
+typedef struct plutovg_glyph_mask {
+    plutovg_codepoint_t codepoint;
+    float size;
+    float scale_x;
+    float scale_y;
+    int subpixel;
+    plutovg_glyph_span_t* spans;
+    int num_spans;
+} plutovg_glyph_mask_t;
+
+typedef struct plutovg_glyph_table {
     size_t capacity;
+    struct plutovg_glyph_table* retired;
+    struct plutovg_glyph_table* flushed;
+    plutovg_atomic_pointer_t entries[];
+} plutovg_glyph_table_t;
+
+typedef struct {
+    plutovg_atomic_pointer_t table;
+    plutovg_atomic_pointer_t flushed;
+    plutovg_atomic_int_t readers;
+    size_t size;
+    size_t memory;
 } plutovg_glyph_cache_t;
 
+#define ADVANCE_PAGE_SIZE 256
+#define ADVANCE_PAGE_COUNT (0x10000 / ADVANCE_PAGE_SIZE)
+
 struct plutovg_font_face {
     plutovg_ref_count_t ref_count;
     int ascent;
@@ -173,113 +203,419 @@ struct plutovg_font_face {
     stbtt_fontinfo info;
     plutovg_mutex_t mutex;
     plutovg_glyph_cache_t cache;
+    plutovg_glyph_cache_t mask_cache;
+    plutovg_atomic_pointer_t advance_pages[ADVANCE_PAGE_COUNT];
     plutovg_destroy_func_t destroy_func;
     void* closure;
 };
 
+/*
+ * The glyph caches are read without locking: entries are never modified once published,
+ * lookups load the table and its slots with acquire semantics, and insertions are serialized
+ * by the face mutex. Growing the table publishes a new copy; the previous tables are retired
+ * and released with the face, since concurrent readers may still hold them.
+ *
+ * A cache with a memory budget is flushed by unpublishing its table, whose entries are then
+ * released once no reader is left. Readers of such a cache bracket their use of its entries
+ * with plutovg_glyph_cache_enter() and plutovg_glyph_cache_leave().
+ */
+
+typedef size_t(*plutovg_glyph_hash_func_t)(const void* entry);
+typedef void(*plutovg_glyph_destroy_func_t)(void* entry);
+
 static void plutovg_glyph_cache_init(plutovg_glyph_cache_t* cache)
 {
-    cache->glyphs = NULL;
+    plutovg_atomic_pointer_init(&cache->table, NULL);
+    plutovg_atomic_pointer_init(&cache->flushed, NULL);
+    plutovg_atomic_int_init(&cache->readers, 0);
     cache->size = 0;
-    cache->capacity = 0;
+    cache->memory = 0;
 }
 
-static void plutovg_glyph_cache_finish(plutovg_glyph_cache_t* cache, plutovg_font_face_t* face)
+static void plutovg_glyph_table_destroy(plutovg_glyph_table_t* table, plutovg_glyph_destroy_func_t destroy_func)
 {
-    plutovg_mutex_lock(&face->mutex);
+    if(table) {
+        for(size_t i = 0; i < table->capacity; ++i) {
+            void* entry = plutovg_atomic_pointer_load(&table->entries[i]);
+            if(entry) {
+                destroy_func(entry);
+            }
+        }
+    }
+
+    while(table) {
+        plutovg_glyph_table_t* retired = table->retired;
+        free(table);
+        table = retired;
+    }
+}
+
+static void plutovg_glyph_table_destroy_flushed(plutovg_glyph_table_t* table, plutovg_glyph_destroy_func_t destroy_func)
+{
+    while(table) {
+        plutovg_glyph_table_t* flushed = table->flushed;
+        plutovg_glyph_table_destroy(table, destroy_func);
+        table = flushed;
+    }
+}
+
+static void plutovg_glyph_cache_finish(plutovg_glyph_cache_t* cache, plutovg_glyph_destroy_func_t destroy_func)
+{
+    plutovg_glyph_table_destroy(plutovg_atomic_pointer_load(&cache->table), destroy_func);
+    plutovg_glyph_table_destroy_flushed(plutovg_atomic_pointer_load(&cache->flushed), destroy_func);
+    plutovg_atomic_pointer_init(&cache->table, NULL);
+    plutovg_atomic_pointer_init(&cache->flushed, NULL);
+    cache->size = 0;
+    cache->memory = 0;
+}
+
+static void plutovg_glyph_cache_flush(plutovg_glyph_cache_t* cache)
+{
+    plutovg_glyph_table_t* table = plutovg_atomic_pointer_load(&cache->table);
+    if(table == NULL)
+        return;
+    table->flushed = plutovg_atomic_pointer_load(&cache->flushed);
+    plutovg_atomic_pointer_store(&cache->flushed, table);
+    plutovg_atomic_pointer_store(&cache->table, NULL);
+    cache->size = 0;
+    cache->memory = 0;
+}
+
+static void plutovg_glyph_cache_enter(plutovg_glyph_cache_t* cache)
+{
+    plutovg_atomic_int_fetch_add(&cache->readers, 1);
+}
+
+static void plutovg_glyph_cache_leave(plutovg_glyph_cache_t* cache, plutovg_mutex_t* mutex, plutovg_glyph_destroy_func_t destroy_func)
+{
+    plutovg_atomic_int_fetch_add(&cache->readers, -1);
+    if(plutovg_atomic_pointer_load(&cache->flushed) == NULL)
+        return;
+    plutovg_glyph_table_t* flushed = NULL;
+    plutovg_mutex_lock(mutex);
+    // A read-modify-write, so readers entering afterwards are ordered after this check.
+    if(plutovg_atomic_int_fetch_add(&cache->readers, 0) == 0) {
+        flushed = plutovg_atomic_pointer_load(&cache->flushed);
+        plutovg_atomic_pointer_store(&cache->flushed, NULL);
+    }
+
+    plutovg_mutex_unlock(mutex);
+    plutovg_glyph_table_destroy_flushed(flushed, destroy_func);
+}
+
+static plutovg_glyph_table_t* plutovg_glyph_table_create(size_t capacity)
+{
+    plutovg_glyph_table_t* table = malloc(sizeof(plutovg_glyph_table_t) + capacity * sizeof(plutovg_atomic_pointer_t));
+    table->capacity = capacity;
+    table->retired = NULL;
+    table->flushed = NULL;
+    for(size_t i = 0; i < capacity; ++i)
+        plutovg_atomic_pointer_init(&table->entries[i], NULL);
+    return table;
+}
+
+static void plutovg_glyph_table_insert(plutovg_glyph_table_t* table, void* entry, size_t hash)
+{
+    size_t index = hash & (table->capacity - 1);
+    while(plutovg_atomic_pointer_load(&table->entries[index]))
+        index = (index + 1) & (table->capacity - 1);
+    plutovg_atomic_pointer_store(&table->entries[index], entry);
+}
+
+#define GLYPH_CACHE_INIT_CAPACITY 256
 
-    if(cache->glyphs) {
-        for(size_t i = 0; i < cache->capacity; ++i) {
-            plutovg_glyph_t* glyph = cache->glyphs[i];
-            while(glyph) {
-                plutovg_glyph_t* next = glyph->next;
-                stbtt_FreeShape(&face->info, glyph->vertices);
-                free(glyph);
-                glyph = next;
+static void plutovg_glyph_cache_insert(plutovg_glyph_cache_t* cache, void* entry, size_t hash, plutovg_glyph_hash_func_t hash_func)
+{
+    plutovg_glyph_table_t* table = plutovg_atomic_pointer_load(&cache->table);
+    if(table == NULL || cache->size + 1 > (table->capacity * 3 / 4)) {
+        plutovg_glyph_table_t* newtable = plutovg_glyph_table_create(table ? table->capacity << 1 : GLYPH_CACHE_INIT_CAPACITY);
+        if(table) {
+            for(size_t i = 0; i < table->capacity; ++i) {
+                void* oldentry = plutovg_atomic_pointer_load(&table->entries[i]);
+                if(oldentry) {
+                    plutovg_glyph_table_insert(newtable, oldentry, hash_func(oldentry));
+                }
             }
         }
 
-        free(cache->glyphs);
-        cache->glyphs = NULL;
-        cache->capacity = 0;
-        cache->size = 0;
+        newtable->retired = table;
+        plutovg_atomic_pointer_store(&cache->table, newtable);
+        table = newtable;
     }
 
-    plutovg_mutex_unlock(&face->mutex);
+    plutovg_glyph_table_insert(table, entry, hash);
+    cache->size += 1;
 }
 
-#define GLYPH_CACHE_INIT_CAPACITY 128
+static size_t plutovg_glyph_hash(const void* entry)
+{
+    const plutovg_glyph_t* glyph = entry;
+    return glyph->codepoint;
+}
 
-static plutovg_glyph_t* plutovg_glyph_cache_get(plutovg_glyph_cache_t* cache, plutovg_font_face_t* face, plutovg_codepoint_t codepoint)
+static void plutovg_glyph_destroy(void* entry)
 {
-    plutovg_mutex_lock(&face->mutex);
+    free(entry);
+}
+
+static void plutovg_glyph_mask_destroy(void* entry)
+{
+    free(entry);
+}
+
+/*
+ * Glyph outlines are kept in font units in the layout the rasterizer consumes: quadratic
+ * segments are converted to cubics once, so drawing a glyph only maps its points.
+ */
+
+static plutovg_glyph_t* plutovg_glyph_create(plutovg_font_face_t* face, int index)
+{
+    stbtt_vertex* vertices;
+    int nvertices = stbtt_GetGlyphShape(&face->info, index, &vertices);
+
+    int num_points = 0;
+    int num_contours = 0;
+    for(int i = 0; i < nvertices; i++) {
+        switch(vertices[i].type) {
+        case STBTT_vmove:
+            num_contours += 1;
+            num_points += 1;
+            break;
+        case STBTT_vline:
+            num_points += 1;
+            break;
+        default:
+            num_points += 3;
+            break;
+        }
+    }
+
+    plutovg_glyph_t* glyph = malloc(sizeof(plutovg_glyph_t) + num_points * (sizeof(plutovg_point_t) + 1) + num_contours * sizeof(int));
+    plutovg_outline_t* outline = &glyph->outline;
+    outline->points = (plutovg_point_t*)(glyph + 1);
+    outline->contours = (int*)(outline->points + num_points);
+    outline->tags = (unsigned char*)(outline->contours + num_contours);
+    outline->num_points = 0;
+    outline->num_contours = 0;
+
+    plutovg_point_t* points = outline->points;
+    unsigned char* tags = outline->tags;
+    plutovg_point_t current_point = {0, 0};
+    for(int i = 0; i < nvertices; i++) {
+        const stbtt_vertex* vertex = &vertices[i];
+        int n = outline->num_points;
+        switch(vertex->type) {
+        case STBTT_vmove:
+            if(n > 0)
+                outline->contours[outline->num_contours++] = n - 1;
+            points[n].x = vertex->x;
+            points[n].y = vertex->y;
+            tags[n] = PLUTOVG_OUTLINE_TAG_ON;
+            outline->num_points += 1;
+            break;
+        case STBTT_vline:
+            points[n].x = vertex->x;
+            points[n].y = vertex->y;
+            tags[n] = PLUTOVG_OUTLINE_TAG_ON;
+            outline->num_points += 1;
+            break;
+        case STBTT_vcurve:
+            points[n].x = 2.f / 3.f * vertex->cx + 1.f / 3.f * current_point.x;
+            points[n].y = 2.f / 3.f * vertex->cy + 1.f / 3.f * current_point.y;
+            points[n + 1].x = 2.f / 3.f * vertex->cx + 1.f / 3.f * vertex->x;
+            points[n + 1].y = 2.f / 3.f * vertex->cy + 1.f / 3.f * vertex->y;
+            points[n + 2].x = vertex->x;
+            points[n + 2].y = vertex->y;
+            tags[n] = tags[n + 1] = PLUTOVG_OUTLINE_TAG_CUBIC;
+            tags[n + 2] = PLUTOVG_OUTLINE_TAG_ON;
+            outline->num_points += 3;
+            break;
+        case STBTT_vcubic:
+            points[n].x = vertex->cx;
+            points[n].y = vertex->cy;
+            points[n + 1].x = vertex->cx1;
+            points[n + 1].y = vertex->cy1;
+            points[n + 2].x = vertex->x;
+            points[n + 2].y = vertex->y;
+            tags[n] = tags[n + 1] = PLUTOVG_OUTLINE_TAG_CUBIC;
+            tags[n + 2] = PLUTOVG_OUTLINE_TAG_ON;
+            outline->num_points += 3;
+            break;
+        default:
+            assert(false);
+        }
 
-    if(cache->glyphs == NULL) {
-        assert(cache->size == 0);
-        cache->glyphs = calloc(GLYPH_CACHE_INIT_CAPACITY, sizeof(plutovg_glyph_t*));
-        cache->capacity = GLYPH_CACHE_INIT_CAPACITY;
+        current_point = points[outline->num_points - 1];
     }
 
-    size_t index = codepoint & (cache->capacity - 1);
-    plutovg_glyph_t* glyph = cache->glyphs[index];
-    while(glyph && glyph->codepoint != codepoint) {
-        glyph = glyph->next;
+    if(outline->num_points > 0)
+        outline->contours[outline->num_contours++] = outline->num_points - 1;
+    stbtt_FreeShape(&face->info, vertices);
+    return glyph;
+}
+
+static plutovg_glyph_t* plutovg_glyph_cache_find(plutovg_glyph_cache_t* cache, plutovg_codepoint_t codepoint)
+{
+    plutovg_glyph_table_t* table = plutovg_atomic_pointer_load(&cache->table);
+    if(table == NULL)
+        return NULL;
+    size_t index = codepoint & (table->capacity - 1);
+    plutovg_glyph_t* glyph;
+    while((glyph = plutovg_atomic_pointer_load(&table->entries[index])) != NULL) {
+        if(glyph->codepoint == codepoint)
+            return glyph;
+        index = (index + 1) & (table->capacity - 1);
     }
 
+    return NULL;
+}
+
+static plutovg_glyph_t* plutovg_glyph_cache_get(plutovg_glyph_cache_t* cache, plutovg_font_face_t* face, plutovg_codepoint_t codepoint)
+{
+    plutovg_glyph_t* glyph = plutovg_glyph_cache_find(cache, codepoint);
+    if(glyph)
+        return glyph;
+    plutovg_mutex_lock(&face->mutex);
+
+    glyph = plutovg_glyph_cache_find(cache, codepoint);
     if(glyph == NULL) {
-        glyph = malloc(sizeof(plutovg_glyph_t));
+        int index = stbtt_FindGlyphIndex(&face->info, codepoint);
+        glyph = plutovg_glyph_create(face, index);
         glyph->codepoint = codepoint;
-        glyph->index = stbtt_FindGlyphIndex(&face->info, codepoint);
-        glyph->nvertices = stbtt_GetGlyphShape(&face->info, glyph->index, &glyph->vertices);
+        glyph->index = index;
         stbtt_GetGlyphHMetrics(&face->info, glyph->index, &glyph->advance_width, &glyph->left_side_bearing);
         if(!stbtt_GetGlyphBox(&face->info, glyph->index, &glyph->x1, &glyph->y1, &glyph->x2, &glyph->y2)) {
             glyph->x1 = glyph->y1 = glyph->x2 = glyph->y2 = 0;
         }
 
-        glyph->next = cache->glyphs[index];
-        cache->glyphs[index] = glyph;
-        cache->size += 1;
-
-        if(cache->size > (cache->capacity * 3 / 4)) {
-            size_t newcapacity = cache->capacity << 1;
-            plutovg_glyph_t** newglyphs = calloc(newcapacity, sizeof(plutovg_glyph_t*));
-
-            for(size_t i = 0; i < cache->capacity; ++i) {
-                plutovg_glyph_t* entry = cache->glyphs[i];
-                while(entry) {
-                    plutovg_glyph_t* next = entry->next;
-                    size_t newindex = entry->codepoint & (newcapacity - 1);
-                    entry->next = newglyphs[newindex];
-                    newglyphs[newindex] = entry;
-                    entry = next;
-                }
-            }
-
-            free(cache->glyphs);
-            cache->glyphs = newglyphs;
-            cache->capacity = newcapacity;
-        }
+        plutovg_glyph_cache_insert(cache, glyph, plutovg_glyph_hash(glyph), plutovg_glyph_hash);
     }
 
     plutovg_mutex_unlock(&face->mutex);
     return glyph;
 }
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <limits.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#ifdef _WIN32
+
+static void* plutovg_mmap(const char* filename, long* length)
+{
+    HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file == INVALID_HANDLE_VALUE)
+        return NULL;
+    DWORD size = GetFileSize(file, NULL);
+    if(size == INVALID_FILE_SIZE) {
+        CloseHandle(file);
+        return NULL;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(mapping == NULL) {
+        CloseHandle(file);
+        return NULL;
+    }
+
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    CloseHandle(file);
+
+    if(data == NULL)
+        return NULL;
+    *length = size;
+    return data;
+}
+
+static void plutovg_unmap(void* data, long length)
+{
+    UnmapViewOfFile(data);
+}
+
+#else
+
+static void* plutovg_mmap(const char* filename, long* length)
+{
+    int fd = open(filename, O_RDONLY);
+    if(fd < 0)
+        return NULL;
+    struct stat st;
+    if(fstat(fd, &st) < 0) {
+        close(fd);
+        return NULL;
+    }
+
+    if(st.st_size == 0) {
+        close(fd);
+        return NULL;
+    }
+
+    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if(data == MAP_FAILED)
+        return NULL;
+    *length = st.st_size;
+    return data;
+}
+
+static void plutovg_unmap(void* data, long length)
+{
+    munmap(data, length);
+}
+
+#endif // _WIN32
+
+typedef struct {
+    void* data;
+    long length;
+} plutovg_font_mapping_t;
+
+static void plutovg_font_mapping_destroy(void* closure)
+{
+    plutovg_font_mapping_t* mapping = closure;
+    plutovg_unmap(mapping->data, mapping->length);
+    free(mapping);
+}
+
 plutovg_font_face_t* plutovg_font_face_load_from_file(const char* filename, int ttcindex)
 {
+    long length;
+    void* data = plutovg_mmap(filename, &length);
+    if(data) {
+        plutovg_font_mapping_t* mapping = malloc(sizeof(plutovg_font_mapping_t));
+        if(mapping == NULL) {
+            plutovg_unmap(data, length);
+            return NULL;
+        }
+
+        mapping->data = data;
+        mapping->length = length;
+        return plutovg_font_face_load_from_data(data, length, ttcindex, plutovg_font_mapping_destroy, mapping);
+    }
+
     FILE* fp = fopen(filename, "rb");
     if(fp == NULL) {
         return NULL;
     }
 
     fseek(fp, 0, SEEK_END);
-    long length = ftell(fp);
+    length = ftell(fp);
     if(length == -1L) {
         fclose(fp);
         return NULL;
     }
 
-    void* data = malloc(length);
+    data = malloc(length);
     if(data == NULL) {
         fclose(fp);
         return NULL;
@@ -314,6 +650,9 @@ plutovg_font_face_t* plutovg_font_face_load_from_data(const void* data, unsigned
     stbtt_GetFontBoundingBox(&face->info, &face->x1, &face->y1, &face->x2, &face->y2);
     plutovg_mutex_init(&face->mutex);
     plutovg_glyph_cache_init(&face->cache);
+    plutovg_glyph_cache_init(&face->mask_cache);
+    for(int i = 0; i < ADVANCE_PAGE_COUNT; ++i)
+        plutovg_atomic_pointer_init(&face->advance_pages[i], NULL);
     face->destroy_func = destroy_func;
     face->closure = closure;
     return face;
@@ -328,7 +667,10 @@ plutovg_font_face_t* plutovg_font_face_reference(plutovg_font_face_t* face)
 void plutovg_font_face_destroy(plutovg_font_face_t* face)
 {
     if(plutovg_destroy_reference(face)) {
-        plutovg_glyph_cache_finish(&face->cache, face);
+        plutovg_glyph_cache_finish(&face->mask_cache, plutovg_glyph_mask_destroy);
+        plutovg_glyph_cache_finish(&face->cache, plutovg_glyph_destroy);
+        for(int i = 0; i < ADVANCE_PAGE_COUNT; ++i)
+            free(plutovg_atomic_pointer_load(&face->advance_pages[i]));
         plutovg_mutex_destroy(&face->mutex);
         if(face->destroy_func)
             face->destroy_func(face->closure);
@@ -365,9 +707,52 @@ static plutovg_glyph_t* plutovg_font_face_get_glyph(plutovg_font_face_t* face, p
     return plutovg_glyph_cache_get(&face->cache, face, codepoint);
 }
 
+/*
+ * Advance widths of the basic multilingual plane are kept in pages of font units, filled
+ * a page at a time on first use and published like the glyph cache entries, so measuring
+ * text does not load glyph outlines or take the face mutex once the pages are warm.
+ */
+
+static const unsigned short* plutovg_font_face_get_advance_page(plutovg_font_face_t* face, plutovg_codepoint_t codepoint)
+{
+    plutovg_atomic_pointer_t* slot = &face->advance_pages[codepoint / ADVANCE_PAGE_SIZE];
+    unsigned short* page = plutovg_atomic_pointer_load(slot);
+    if(page)
+        return page;
+    plutovg_mutex_lock(&face->mutex);
+
+    page = plutovg_atomic_pointer_load(slot);
+    if(page == NULL) {
+        page = malloc(ADVANCE_PAGE_SIZE * sizeof(unsigned short));
+        plutovg_codepoint_t first = codepoint - codepoint % ADVANCE_PAGE_SIZE;
+        for(int i = 0; i < ADVANCE_PAGE_SIZE; ++i) {
+            int advance_width;
+            stbtt_GetGlyphHMetrics(&face->info, stbtt_FindGlyphIndex(&face->info, first + i), &advance_width, NULL);
+            page[i] = advance_width;
+        }
+
+        plutovg_atomic_pointer_store(slot, page);
+    }
+
+    plutovg_mutex_unlock(&face->mutex);
+    return page;
+}
+
+static int plutovg_font_face_get_advance_width(plutovg_font_face_t* face, plutovg_codepoint_t codepoint)
+{
+    if(codepoint < ADVANCE_PAGE_SIZE * ADVANCE_PAGE_COUNT)
+        return plutovg_font_face_get_advance_page(face, codepoint)[codepoint % ADVANCE_PAGE_SIZE];
+    return plutovg_font_face_get_glyph(face, codepoint)->advance_width;
+}
+
 void plutovg_font_face_get_glyph_metrics(plutovg_font_face_t* face, float size, plutovg_codepoint_t codepoint, float* advance_width, float* left_side_bearing, plutovg_rect_t* extents)
 {
     float scale = plutovg_font_face_get_scale(face, size);
+    if(left_side_bearing == NULL && extents == NULL) {
+        if(advance_width) *advance_width = plutovg_font_face_get_advance_width(face, codepoint) * scale;
+        return;
+    }
+
     plutovg_glyph_t* glyph = plutovg_font_face_get_glyph(face, codepoint);
     if(advance_width) *advance_width = glyph->advance_width * scale;
     if(left_side_bearing) *left_side_bearing = glyph->left_side_bearing * scale;
@@ -410,49 +795,25 @@ float plutovg_font_face_traverse_glyph_path(plutovg_font_face_t* face, float siz
     plutovg_matrix_scale(&matrix, scale, -scale);
 
     plutovg_point_t points[3];
-    plutovg_point_t current_point = {0, 0};
     plutovg_glyph_t* glyph = plutovg_font_face_get_glyph(face, codepoint);
-    for(int i = 0; i < glyph->nvertices; i++) {
-        switch(glyph->vertices[i].type) {
-        case STBTT_vmove:
-            points[0].x = glyph->vertices[i].x;
-            points[0].y = glyph->vertices[i].y;
-            current_point = points[0];
-            plutovg_matrix_map_points(&matrix, points, points, 1);
-            traverse_func(closure, PLUTOVG_PATH_COMMAND_MOVE_TO, points, 1);
-            break;
-        case STBTT_vline:
-            points[0].x = glyph->vertices[i].x;
-            points[0].y = glyph->vertices[i].y;
-            current_point = points[0];
-            plutovg_matrix_map_points(&matrix, points, points, 1);
-            traverse_func(closure, PLUTOVG_PATH_COMMAND_LINE_TO, points, 1);
-            break;
-        case STBTT_vcurve:
-            points[0].x = 2.f / 3.f * glyph->vertices[i].cx + 1.f / 3.f * current_point.x;
-            points[0].y = 2.f / 3.f * glyph->vertices[i].cy + 1.f / 3.f * current_point.y;
-            points[1].x = 2.f / 3.f * glyph->vertices[i].cx + 1.f / 3.f * glyph->vertices[i].x;
-            points[1].y = 2.f / 3.f * glyph->vertices[i].cy + 1.f / 3.f * glyph->vertices[i].y;
-            points[2].x = glyph->vertices[i].x;
-            points[2].y = glyph->vertices[i].y;
-            current_point = points[2];
-            plutovg_matrix_map_points(&matrix, points, points, 3);
-            traverse_func(closure, PLUTOVG_PATH_COMMAND_CUBIC_TO, points, 3);
-            break;
-        case STBTT_vcubic:
-            points[0].x = glyph->vertices[i].cx;
-            points[0].y = glyph->vertices[i].cy;
-            points[1].x = glyph->vertices[i].cx1;
-            points[1].y = glyph->vertices[i].cy1;
-            points[2].x = glyph->vertices[i].x;
-            points[2].y = glyph->vertices[i].y;
-            current_point = points[2];
-            plutovg_matrix_map_points(&matrix, points, points, 3);
-            traverse_func(closure, PLUTOVG_PATH_COMMAND_CUBIC_TO, points, 3);
-            break;
-        default:
-            assert(false);
+    const plutovg_outline_t* outline = &glyph->outline;
+    int start = 0;
+    for(int i = 0; i < outline->num_contours; i++) {
+        int end = outline->contours[i];
+        plutovg_matrix_map_points(&matrix, &outline->points[start], points, 1);
+        traverse_func(closure, PLUTOVG_PATH_COMMAND_MOVE_TO, points, 1);
+        for(int j = start + 1; j <= end; j++) {
+            if(outline->tags[j] == PLUTOVG_OUTLINE_TAG_CUBIC) {
+                plutovg_matrix_map_points(&matrix, &outline->points[j], points, 3);
+                traverse_func(closure, PLUTOVG_PATH_COMMAND_CUBIC_TO, points, 3);
+                j += 2;
+            } else {
+                plutovg_matrix_map_points(&matrix, &outline->points[j], points, 1);
+                traverse_func(closure, PLUTOVG_PATH_COMMAND_LINE_TO, points, 1);
+            }
         }
+
+        start = end + 1;
     }
 
     return glyph->advance_width * scale;
@@ -464,16 +825,20 @@ float plutovg_font_face_text_extents(plutovg_font_face_t* face, float size, cons
     plutovg_text_iterator_init(&it, text, length, encoding);
     plutovg_rect_t* text_extents = NULL;
     float total_advance_width = 0.f;
+    if(extents == NULL) {
+        float scale = plutovg_font_face_get_scale(face, size);
+        while(plutovg_text_iterator_has_next(&it)) {
+            plutovg_codepoint_t codepoint = plutovg_text_iterator_next(&it);
+            total_advance_width += plutovg_font_face_get_advance_width(face, codepoint) * scale;
+        }
+
+        return total_advance_width;
+    }
+
     while(plutovg_text_iterator_has_next(&it)) {
         plutovg_codepoint_t codepoint = plutovg_text_iterator_next(&it);
 
         float advance_width;
-        if(extents == NULL) {
-            plutovg_font_face_get_glyph_metrics(face, size, codepoint, &advance_width, NULL, NULL);
-            total_advance_width += advance_width;
-            continue;
-        }
-
         plutovg_rect_t glyph_extents;
         plutovg_font_face_get_glyph_metrics(face, size, codepoint, &advance_width, NULL, &glyph_extents);
 
@@ -506,41 +871,502 @@ float plutovg_font_face_text_extents(plutovg_font_face_t* face, float size, cons
     return total_advance_width;
 }
 
-typedef struct plutovg_font_face_entry {
-    plutovg_font_face_t* face;
-    char* family;
-    char* filename;
-    int ttcindex;
-    bool bold;
-    bool italic;
-    struct plutovg_font_face_entry* next;
-} plutovg_font_face_entry_t;
-
-struct plutovg_font_face_cache {
-    plutovg_ref_count_t ref_count;
-    plutovg_mutex_t mutex;
-    plutovg_font_face_entry_t** entries;
-    int size;
-    int capacity;
-    bool is_sorted;
-};
+#define GLYPH_MASK_CACHE_MAX_MEMORY (2 * 1024 * 1024)
+#define GLYPH_MASK_MAX_SIZE 256.f
+#define GLYPH_MASK_SUBPIXELS 4
 
-plutovg_font_face_cache_t* plutovg_font_face_cache_create(void)
+static size_t plutovg_glyph_mask_key_hash(plutovg_codepoint_t codepoint, float size, float scale_x, int subpixel)
 {
-    plutovg_font_face_cache_t* cache = malloc(sizeof(plutovg_font_face_cache_t));
-    plutovg_init_reference(cache);
-    plutovg_mutex_init(&cache->mutex);
-    cache->entries = NULL;
-    cache->size = 0;
-    cache->capacity = 0;
-    cache->is_sorted = false;
-    return cache;
+    return (codepoint * 37 + subpixel) ^ ((size_t)(fabsf(size * scale_x) * 16.f) * 131);
 }
 
-plutovg_font_face_cache_t* plutovg_font_face_cache_reference(plutovg_font_face_cache_t* cache)
+static size_t plutovg_glyph_mask_hash(const void* entry)
 {
-    plutovg_increment_reference(cache);
-    return cache;
+    const plutovg_glyph_mask_t* mask = entry;
+    return plutovg_glyph_mask_key_hash(mask->codepoint, mask->size, mask->scale_x, mask->subpixel);
+}
+
+static plutovg_glyph_mask_t* plutovg_glyph_mask_create(plutovg_font_face_t* face, plutovg_codepoint_t codepoint, float size, float scale_x, float scale_y, int subpixel)
+{
+    float scale = plutovg_font_face_get_scale(face, size);
+    plutovg_glyph_t* glyph = plutovg_font_face_get_glyph(face, codepoint);
+
+    /*
+     * The rasterizer halves coordinates with truncating division, so rasterizing around the
+     * origin would not match the glyph drawn at a positive position. The mask is rasterized
+     * at a positive whole pixel offset instead, and the spans are moved back.
+     */
+    float extent = plutovg_max(plutovg_max(abs(glyph->x1), abs(glyph->x2)), plutovg_max(abs(glyph->y1), abs(glyph->y2))) * scale;
+    int offset = (int)(ceilf(extent * plutovg_max(fabsf(scale_x), fabsf(scale_y)))) + 1;
+
+    plutovg_matrix_t matrix;
+    plutovg_matrix_init_scale(&matrix, scale, -scale);
+    plutovg_matrix_t device = {scale_x, 0, 0, scale_y, offset + (subpixel & (GLYPH_MASK_SUBPIXELS - 1)) / (float)(GLYPH_MASK_SUBPIXELS), offset};
+    plutovg_matrix_multiply(&matrix, &matrix, &device);
+    plutovg_fill_rule_t winding = (subpixel / GLYPH_MASK_SUBPIXELS) ? PLUTOVG_FILL_RULE_EVEN_ODD : PLUTOVG_FILL_RULE_NON_ZERO;
+
+    plutovg_span_buffer_t span_buffer;
+    plutovg_span_buffer_init(&span_buffer);
+    if(glyph->outline.num_points > 0) {
+        const plutovg_outline_t* outline = &glyph->outline;
+        plutovg_rasterize_outlines(&span_buffer, &outline, &matrix, 1, NULL, winding, NULL, NULL);
+    }
+
+    int num_spans = span_buffer.spans.size;
+    plutovg_glyph_mask_t* mask = malloc(sizeof(plutovg_glyph_mask_t) + num_spans * sizeof(plutovg_glyph_span_t));
+    if(mask == NULL) {
+        plutovg_span_buffer_destroy(&span_buffer);
+        return NULL;
+    }
+
+    mask->codepoint = codepoint;
+    mask->size = size;
+    mask->scale_x = scale_x;
+    mask->scale_y = scale_y;
+    mask->subpixel = subpixel;
+    mask->spans = (plutovg_glyph_span_t*)(mask + 1);
+    mask->num_spans = 0;
+    for(int i = 0; i < num_spans; ++i) {
+        const plutovg_span_t* span = &span_buffer.spans.data[i];
+        int x = span->x - offset;
+        int y = span->y - offset;
+        if(x < SHRT_MIN || x + span->len > SHRT_MAX || y < SHRT_MIN || y > SHRT_MAX)
+            continue;
+        plutovg_glyph_span_t* glyph_span = &mask->spans[mask->num_spans++];
+        glyph_span->x = x;
+        glyph_span->len = span->len;
+        glyph_span->y = y;
+        glyph_span->coverage = span->coverage;
+    }
+
+    plutovg_span_buffer_destroy(&span_buffer);
+    return mask;
+}
+
+static plutovg_glyph_mask_t* plutovg_glyph_mask_cache_find(plutovg_glyph_cache_t* cache, plutovg_codepoint_t codepoint, float size, float scale_x, float scale_y, int subpixel)
+{
+    plutovg_glyph_table_t* table = plutovg_atomic_pointer_load(&cache->table);
+    if(table == NULL)
+        return NULL;
+    size_t index = plutovg_glyph_mask_key_hash(codepoint, size, scale_x, subpixel) & (table->capacity - 1);
+    plutovg_glyph_mask_t* mask;
+    while((mask = plutovg_atomic_pointer_load(&table->entries[index])) != NULL) {
+        if(mask->codepoint == codepoint && mask->subpixel == subpixel && mask->size == size
+            && mask->scale_x == scale_x && mask->scale_y == scale_y) {
+            return mask;
+        }
+
+        index = (index + 1) & (table->capacity - 1);
+    }
+
+    return NULL;
+}
+
+static plutovg_glyph_mask_t* plutovg_glyph_mask_cache_get(plutovg_glyph_cache_t* cache, plutovg_font_face_t* face, plutovg_codepoint_t codepoint, float size, float scale_x, float scale_y, int subpixel)
+{
+    plutovg_glyph_mask_t* mask = plutovg_glyph_mask_cache_find(cache, codepoint, size, scale_x, scale_y, subpixel);
+    if(mask)
+        return mask;
+    plutovg_glyph_mask_t* newmask = plutovg_glyph_mask_create(face, codepoint, size, scale_x, scale_y, subpixel);
+    if(newmask == NULL)
+        return NULL;
+    size_t memory = sizeof(plutovg_glyph_mask_t) + newmask->num_spans * sizeof(plutovg_glyph_span_t);
+
+    plutovg_mutex_lock(&face->mutex);
+
+    mask = plutovg_glyph_mask_cache_find(cache, codepoint, size, scale_x, scale_y, subpixel);
+    if(mask) {
+        free(newmask);
+    } else {
+        if(cache->memory + memory > GLYPH_MASK_CACHE_MAX_MEMORY)
+            plutovg_glyph_cache_flush(cache);
+        plutovg_glyph_cache_insert(cache, newmask, plutovg_glyph_mask_hash(newmask), plutovg_glyph_mask_hash);
+        cache->memory += memory;
+        mask = newmask;
+    }
+
+    plutovg_mutex_unlock(&face->mutex);
+    return mask;
+}
+
+typedef struct {
+    plutovg_codepoint_t codepoint;
+    int subpixel;
+    int x;
+    int y;
+    float left;
+    float top;
+    float right;
+    float bottom;
+} plutovg_glyph_placement_t;
+
+static int plutovg_glyph_placement_compare(const void* a, const void* b)
+{
+    const plutovg_glyph_placement_t* a_placement = a;
+    const plutovg_glyph_placement_t* b_placement = b;
+    if(a_placement->left < b_placement->left)
+        return -1;
+    return a_placement->left > b_placement->left;
+}
+
+/*
+ * Adding the coverage of separately rasterized glyphs only matches rasterizing them as one
+ * path while their outlines stay apart, so runs whose glyph boxes overlap (kerned pairs,
+ * italics, negative side bearings or letter spacing) take the outline path instead.
+ */
+static bool plutovg_glyph_placements_overlap(plutovg_glyph_placement_t* placements, int count)
+{
+    qsort(placements, count, sizeof(plutovg_glyph_placement_t), plutovg_glyph_placement_compare);
+    for(int i = 0; i < count; ++i) {
+        const plutovg_glyph_placement_t* a = &placements[i];
+        for(int j = i + 1; j < count && placements[j].left < a->right; ++j) {
+            const plutovg_glyph_placement_t* b = &placements[j];
+            if(b->top < a->bottom && a->top < b->bottom) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+typedef struct {
+    int x;
+    int coverage;
+} plutovg_coverage_edge_t;
+
+static int plutovg_coverage_edge_compare(const void* a, const void* b)
+{
+    const plutovg_coverage_edge_t* a_edge = a;
+    const plutovg_coverage_edge_t* b_edge = b;
+    return (a_edge->x > b_edge->x) - (a_edge->x < b_edge->x);
+}
+
+/*
+ * Orders the spans of separately placed glyph masks by row and sums the coverage
+ * where the spans of neighbouring glyphs share pixels, saturating at full coverage.
+ * The glyphs are placed from left to right, so the spans of a row are bucketed in
+ * their original order and only rows whose spans overlap or go backwards are sorted.
+ */
+static bool plutovg_glyph_spans_merge(plutovg_span_buffer_t* span_buffer)
+{
+    int count = span_buffer->spans.size;
+    if(count <= 0)
+        return true;
+    int y1 = INT_MAX;
+    int y2 = INT_MIN;
+    for(int i = 0; i < count; ++i) {
+        y1 = plutovg_min(y1, span_buffer->spans.data[i].y);
+        y2 = plutovg_max(y2, span_buffer->spans.data[i].y);
+    }
+
+    int height = y2 - y1 + 1;
+    int* rows = calloc((size_t)height + 1, sizeof(int));
+    plutovg_span_t* spans = malloc((size_t)count * sizeof(plutovg_span_t));
+    if(rows == NULL || spans == NULL) {
+        free(rows);
+        free(spans);
+        return false;
+    }
+
+    for(int i = 0; i < count; ++i)
+        rows[span_buffer->spans.data[i].y - y1 + 1]++;
+    for(int i = 0; i < height; ++i)
+        rows[i + 1] += rows[i];
+    for(int i = 0; i < count; ++i) {
+        const plutovg_span_t* span = &span_buffer->spans.data[i];
+        spans[rows[span->y - y1]++] = *span;
+    }
+
+    struct {
+        plutovg_coverage_edge_t* data;
+        int size;
+        int capacity;
+    } edges;
+
+    plutovg_array_init(edges);
+    plutovg_array_clear(span_buffer->spans);
+    for(int i = 0; i < count;) {
+        const plutovg_span_t* row = spans + i;
+        int row_count = 1;
+        int end = row[0].x + row[0].len;
+        bool ordered = true;
+        while(i + row_count < count && row[row_count].y == row[0].y) {
+            ordered &= row[row_count].x >= end;
+            end = plutovg_max(end, row[row_count].x + row[row_count].len);
+            ++row_count;
+        }
+
+        i += row_count;
+        if(ordered) {
+            plutovg_array_append_data(span_buffer->spans, row, row_count);
+            continue;
+        }
+
+        plutovg_array_clear(edges);
+        plutovg_array_ensure(edges, 2 * row_count);
+        for(int j = 0; j < row_count; ++j) {
+            edges.data[edges.size].x = row[j].x;
+            edges.data[edges.size++].coverage = row[j].coverage;
+            edges.data[edges.size].x = row[j].x + row[j].len;
+            edges.data[edges.size++].coverage = -row[j].coverage;
+        }
+
+        qsort(edges.data, edges.size, sizeof(plutovg_coverage_edge_t), plutovg_coverage_edge_compare);
+        int coverage = 0;
+        for(int j = 0; j < edges.size; ++j) {
+            const plutovg_coverage_edge_t* edge = &edges.data[j];
+            if(coverage > 0 && edge->x > edges.data[j - 1].x) {
+                plutovg_array_ensure(span_buffer->spans, 1);
+                plutovg_span_t* span = &span_buffer->spans.data[span_buffer->spans.size++];
+                span->x = edges.data[j - 1].x;
+                span->len = edge->x - edges.data[j - 1].x;
+                span->y = row[0].y;
+                span->coverage = plutovg_min(coverage, 255);
+            }
+
+            coverage += edge->coverage;
+        }
+    }
+
+    plutovg_array_destroy(edges);
+    free(spans);
+    free(rows);
+    return true;
+}
+
+static void plutovg_font_face_rasterize_text_outlines(plutovg_font_face_t* face, float size, const plutovg_matrix_t* matrix, plutovg_fill_rule_t winding, const plutovg_rect_t* clip_rect,
+    const plutovg_text_run_t* runs, int count, plutovg_text_encoding_t encoding, plutovg_span_buffer_t* span_buffer, const plutovg_raster_config_t* config, plutovg_raster_pool_t* pool, float* advance_width)
+{
+    struct {
+        const plutovg_outline_t** data;
+        int size;
+        int capacity;
+    } outlines;
+
+    struct {
+        plutovg_matrix_t* data;
+        int size;
+        int capacity;
+    } matrices;
+
+    plutovg_array_init(outlines);
+    plutovg_array_init(matrices);
+
+    float scale = plutovg_font_face_get_scale(face, size);
+    float total_advance_width = 0.f;
+    for(int i = 0; i < count; ++i) {
+        const plutovg_text_run_t* run = &runs[i];
+
+        plutovg_text_iterator_t it;
+        plutovg_text_iterator_init(&it, run->text, run->length, encoding);
+        float run_advance_width = 0.f;
+        while(plutovg_text_iterator_has_next(&it)) {
+            plutovg_codepoint_t codepoint = plutovg_text_iterator_next(&it);
+            plutovg_glyph_t* glyph = plutovg_font_face_get_glyph(face, codepoint);
+            if(glyph->outline.num_points > 0) {
+                plutovg_array_ensure(outlines, 1);
+                plutovg_array_ensure(matrices, 1);
+                plutovg_matrix_t* glyph_matrix = &matrices.data[matrices.size++];
+                plutovg_matrix_init_translate(glyph_matrix, run->x + run_advance_width, run->y);
+                plutovg_matrix_scale(glyph_matrix, scale, -scale);
+                plutovg_matrix_multiply(glyph_matrix, glyph_matrix, matrix);
+                outlines.data[outlines.size++] = &glyph->outline;
+            }
+
+            run_advance_width += glyph->advance_width * scale;
+        }
+
+        total_advance_width += run_advance_width;
+    }
+
+    plutovg_rasterize_outlines(span_buffer, outlines.data, matrices.data, outlines.size, clip_rect, winding, config, pool);
+    plutovg_array_destroy(outlines);
+    plutovg_array_destroy(matrices);
+    if(advance_width) {
+        *advance_width = total_advance_width;
+    }
+}
+
+void plutovg_font_face_rasterize_text(plutovg_font_face_t* face, float size, const plutovg_matrix_t* matrix, plutovg_fill_rule_t winding, const plutovg_rect_t* clip_rect,
+    const plutovg_text_run_t* runs, int count, plutovg_text_encoding_t encoding, plutovg_span_buffer_t* span_buffer, const plutovg_raster_config_t* config, plutovg_raster_pool_t* pool, float* advance_width)
+{
+    if(config == NULL || !config->glyph_cache || matrix->b != 0.f || matrix->c != 0.f || matrix->a == 0.f || matrix->d == 0.f
+        || fabsf(size * matrix->a) > GLYPH_MASK_MAX_SIZE || fabsf(size * matrix->d) > GLYPH_MASK_MAX_SIZE) {
+        plutovg_font_face_rasterize_text_outlines(face, size, matrix, winding, clip_rect, runs, count, encoding, span_buffer, config, pool, advance_width);
+        return;
+    }
+
+    struct {
+        plutovg_glyph_placement_t* data;
+        int size;
+        int capacity;
+    } placements;
+
+    plutovg_array_init(placements);
+
+    float scale = plutovg_font_face_get_scale(face, size);
+    float total_advance_width = 0.f;
+    for(int i = 0; i < count; ++i) {
+        const plutovg_text_run_t* run = &runs[i];
+
+        float pen_y = floorf(matrix->d * run->y + matrix->f + 0.5f);
+
+        plutovg_text_iterator_t it;
+        plutovg_text_iterator_init(&it, run->text, run->length, encoding);
+        float run_advance_width = 0.f;
+        while(plutovg_text_iterator_has_next(&it)) {
+            plutovg_codepoint_t codepoint = plutovg_text_iterator_next(&it);
+            const plutovg_glyph_t* glyph = plutovg_font_face_get_glyph(face, codepoint);
+
+            float pen_x = matrix->a * (run->x + run_advance_width) + matrix->e;
+            run_advance_width += glyph->advance_width * scale;
+            if(glyph->outline.num_points == 0)
+                continue;
+            float pen_ix = floorf(pen_x);
+            int subpixel_x = (int)((pen_x - pen_ix) * GLYPH_MASK_SUBPIXELS + 0.5f);
+            if(subpixel_x == GLYPH_MASK_SUBPIXELS) {
+                subpixel_x = 0;
+                pen_ix += 1.f;
+            }
+
+            plutovg_array_ensure(placements, 1);
+            plutovg_glyph_placement_t* placement = &placements.data[placements.size++];
+            placement->codepoint = codepoint;
+            placement->subpixel = subpixel_x + GLYPH_MASK_SUBPIXELS * (winding == PLUTOVG_FILL_RULE_EVEN_ODD);
+            placement->x = (int)(pen_ix);
+            placement->y = (int)(pen_y);
+
+            float left = pen_x + matrix->a * scale * glyph->x1;
+            float right = pen_x + matrix->a * scale * glyph->x2;
+            float top = pen_y - matrix->d * scale * glyph->y2;
+            float bottom = pen_y - matrix->d * scale * glyph->y1;
+            placement->left = plutovg_min(left, right);
+            placement->right = plutovg_max(left, right);
+            placement->top = plutovg_min(top, bottom);
+            placement->bottom = plutovg_max(top, bottom);
+        }
+
+        total_advance_width += run_advance_width;
+    }
+
+    if(plutovg_glyph_placements_overlap(placements.data, placements.size)) {
+        plutovg_array_destroy(placements);
+        plutovg_font_face_rasterize_text_outlines(face, size, matrix, winding, clip_rect, runs, count, encoding, span_buffer, config, pool, advance_width);
+        return;
+    }
+
+    int x1 = INT_MIN;
+    int y1 = INT_MIN;
+    int x2 = INT_MAX;
+    int y2 = INT_MAX;
+    if(clip_rect) {
+        x1 = (int)floorf(clip_rect->x);
+        y1 = (int)floorf(clip_rect->y);
+        x2 = (int)ceilf(clip_rect->x + clip_rect->w);
+        y2 = (int)ceilf(clip_rect->y + clip_rect->h);
+    }
+
+    plutovg_span_buffer_reset(span_buffer);
+    plutovg_glyph_cache_enter(&face->mask_cache);
+    for(int i = 0; i < placements.size; ++i) {
+        const plutovg_glyph_placement_t* placement = &placements.data[i];
+        const plutovg_glyph_mask_t* mask = plutovg_glyph_mask_cache_get(&face->mask_cache, face, placement->codepoint, size, matrix->a, matrix->d, placement->subpixel);
+        if(mask == NULL) {
+            plutovg_glyph_cache_leave(&face->mask_cache, &face->mutex, plutovg_glyph_mask_destroy);
+            plutovg_array_destroy(placements);
+            plutovg_font_face_rasterize_text_outlines(face, size, matrix, winding, clip_rect, runs, count, encoding, span_buffer, config, pool, advance_width);
+            return;
+        }
+
+        plutovg_array_ensure(span_buffer->spans, mask->num_spans);
+        for(int j = 0; j < mask->num_spans; ++j) {
+            const plutovg_glyph_span_t* glyph_span = &mask->spans[j];
+            int y = placement->y + glyph_span->y;
+            int start = plutovg_max(placement->x + glyph_span->x, x1);
+            int end = plutovg_min(placement->x + glyph_span->x + glyph_span->len, x2);
+            if(y < y1 || y >= y2 || start >= end)
+                continue;
+            plutovg_span_t* span = &span_buffer->spans.data[span_buffer->spans.size++];
+            span->x = start;
+            span->len = end - start;
+            span->y = y;
+            span->coverage = glyph_span->coverage;
+        }
+    }
+
+    plutovg_glyph_cache_leave(&face->mask_cache, &face->mutex, plutovg_glyph_mask_destroy);
+    plutovg_array_destroy(placements);
+    if(!plutovg_glyph_spans_merge(span_buffer)) {
+        plutovg_font_face_rasterize_text_outlines(face, size, matrix, winding, clip_rect, runs, count, encoding, span_buffer, config, pool, advance_width);
+        return;
+    }
+
+    if(advance_width) {
+        *advance_width = total_advance_width;
+    }
+}
+
+typedef struct {
+    plutovg_ref_count_t ref_count;
+    const stbtt_uint8* data;
+    unsigned int length;
+    plutovg_destroy_func_t destroy_func;
+    void* closure;
+} plutovg_font_data_t;
+
+static plutovg_font_data_t* plutovg_font_data_reference(plutovg_font_data_t* data)
+{
+    plutovg_increment_reference(data);
+    return data;
+}
+
+static void plutovg_font_data_destroy(void* closure)
+{
+    plutovg_font_data_t* data = closure;
+    if(plutovg_destroy_reference(data)) {
+        if(data->destroy_func)
+            data->destroy_func(data->closure);
+        free(data);
+    }
+}
+
+typedef struct plutovg_font_face_entry {
+    plutovg_font_face_t* face;
+    plutovg_font_data_t* data;
+    char* family;
+    char* filename;
+    int ttcindex;
+    bool bold;
+    bool italic;
+    struct plutovg_font_face_entry* next;
+} plutovg_font_face_entry_t;
+
+struct plutovg_font_face_cache {
+    plutovg_ref_count_t ref_count;
+    plutovg_mutex_t mutex;
+    plutovg_font_face_entry_t** entries;
+    int size;
+    int capacity;
+    bool is_sorted;
+};
+
+plutovg_font_face_cache_t* plutovg_font_face_cache_create(void)
+{
+    plutovg_font_face_cache_t* cache = malloc(sizeof(plutovg_font_face_cache_t));
+    plutovg_init_reference(cache);
+    plutovg_mutex_init(&cache->mutex);
+    cache->entries = NULL;
+    cache->size = 0;
+    cache->capacity = 0;
+    cache->is_sorted = false;
+    return cache;
+}
+
+plutovg_font_face_cache_t* plutovg_font_face_cache_reference(plutovg_font_face_cache_t* cache)
+{
+    plutovg_increment_reference(cache);
+    return cache;
 }
 
 void plutovg_font_face_cache_destroy(plutovg_font_face_cache_t* cache)
@@ -566,6 +1392,7 @@ void plutovg_font_face_cache_reset(plutovg_font_face_cache_t* cache)
         do {
             plutovg_font_face_entry_t* next = entry->next;
             plutovg_font_face_destroy(entry->face);
+            plutovg_font_data_destroy(entry->data);
             free(entry);
             entry = next;
         } while(entry);
@@ -612,6 +1439,7 @@ void plutovg_font_face_cache_add(plutovg_font_face_cache_t* cache, const char* f
 
     plutovg_font_face_entry_t* entry = malloc(family_length + sizeof(plutovg_font_face_entry_t));
     entry->face = plutovg_font_face_reference(face);
+    entry->data = NULL;
     entry->family = (char*)(entry + 1);
     memcpy(entry->family, family, family_length);
 
@@ -677,8 +1505,15 @@ plutovg_font_face_t* plutovg_font_face_cache_get(plutovg_font_face_cache_t* cach
             entry = entry->next;
         }
 
-        if(selected->filename && selected->face == NULL)
-            selected->face = plutovg_font_face_load_from_file(selected->filename, selected->ttcindex);
+        if(selected->face == NULL) {
+            if(selected->filename) {
+                selected->face = plutovg_font_face_load_from_file(selected->filename, selected->ttcindex);
+            } else if(selected->data) {
+                plutovg_font_data_t* data = plutovg_font_data_reference(selected->data);
+                selected->face = plutovg_font_face_load_from_data(data->data, data->length, selected->ttcindex, plutovg_font_data_destroy, data);
+            }
+        }
+
         face = selected->face;
     }
 
@@ -686,251 +1521,544 @@ plutovg_font_face_t* plutovg_font_face_cache_get(plutovg_font_face_cache_t* cach
     return face;
 }
 
-#ifndef PLUTOVG_DISABLE_FONT_FACE_CACHE_LOAD
+static plutovg_font_face_entry_t* plutovg_font_face_entry_create(stbtt_uint8* data, int index, const char* filename)
+{
+    int offset = stbtt_GetFontOffsetForIndex(data, index);
+    if(offset == -1 || !stbtt__isfont(data + offset)) {
+        return NULL;
+    }
 
-#include <ctype.h>
+    stbtt_uint32 nm = stbtt__find_table(data, offset, "name");
+    stbtt_uint16 nm_count = ttUSHORT(data + nm + 2);
 
-#ifdef _WIN32
-#include <windows.h>
-#else
-#include <fcntl.h>
-#include <unistd.h>
-#include <dirent.h>
-#include <limits.h>
+    const stbtt_uint8* unicode_family_name = NULL;
+    const stbtt_uint8* roman_family_name = NULL;
 
-#include <sys/mman.h>
-#include <sys/stat.h>
-#endif
+    size_t family_length = 0;
+    for(stbtt_int32 i = 0; i < nm_count; ++i) {
+        stbtt_uint32 loc = nm + 6 + 12 * i;
+        stbtt_uint16 nm_id = ttUSHORT(data + loc + 6);
+        if(nm_id != 1) {
+            continue;
+        }
 
-#ifdef _WIN32
+        stbtt_uint16 platform = ttUSHORT(data + loc + 0);
+        stbtt_uint16 encoding = ttUSHORT(data + loc + 2);
 
-static void* plutovg_mmap(const char* filename, long* length)
-{
-    HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
-    if(file == INVALID_HANDLE_VALUE)
-        return NULL;
-    DWORD size = GetFileSize(file, NULL);
-    if(size == INVALID_FILE_SIZE) {
-        CloseHandle(file);
-        return NULL;
+        const stbtt_uint8* family_name = data + nm + ttUSHORT(data + nm + 4) + ttUSHORT(data + loc + 10);
+        if(platform == 1 && encoding == 0) {
+            family_length = ttUSHORT(data + loc + 8);
+            roman_family_name = family_name;
+            continue;
+        }
+
+        if(platform == 0 || (platform == 3 && encoding == 1) || (platform == 3 && encoding == 10)) {
+            family_length = ttUSHORT(data + loc + 8);
+            unicode_family_name = family_name;
+            break;
+        }
     }
 
-    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
-    if(mapping == NULL) {
-        CloseHandle(file);
+    if(unicode_family_name == NULL && roman_family_name == NULL)
         return NULL;
+    size_t filename_length = filename ? strlen(filename) + 1 : 0;
+    size_t max_family_length = (unicode_family_name ? 3 * (family_length / 2) : family_length * 3) + 1;
+
+    plutovg_font_face_entry_t* entry = malloc(max_family_length + filename_length + sizeof(plutovg_font_face_entry_t));
+    entry->family = (char*)(entry + 1);
+    entry->filename = NULL;
+    if(filename) {
+        entry->filename = entry->family + max_family_length;
+        memcpy(entry->filename, filename, filename_length);
     }
 
-    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
-    CloseHandle(mapping);
-    CloseHandle(file);
+    size_t family_index = 0;
+    if(unicode_family_name) {
+        const stbtt_uint8* family_name = unicode_family_name;
+        while(family_length) {
+            stbtt_uint16 ch = family_name[0] * 256 + family_name[1];
+            if(ch < 0x80) {
+                entry->family[family_index++] = ch;
+            } else if(ch < 0x800) {
+                entry->family[family_index++] = (0xc0 + (ch >> 6));
+                entry->family[family_index++] = (0x80 + (ch & 0x3f));
+            } else if(ch >= 0xd800 && ch < 0xdc00) {
+                stbtt_uint16 ch2 = family_name[2] * 256 + family_name[3];
+                stbtt_uint32 c = ((ch - 0xd800) << 10) + (ch2 - 0xdc00) + 0x10000;
+
+                entry->family[family_index++] = (0xf0 + (c >> 18));
+                entry->family[family_index++] = (0x80 + ((c >> 12) & 0x3f));
+                entry->family[family_index++] = (0x80 + ((c >> 6) & 0x3f));
+                entry->family[family_index++] = (0x80 + ((c) & 0x3f));
 
-    if(data == NULL)
-        return NULL;
-    *length = size;
-    return data;
+                family_name += 2;
+                family_length -= 2;
+            } else {
+                entry->family[family_index++] = (0xe0 + (ch >> 12));
+                entry->family[family_index++] = (0x80 + ((ch >> 6) & 0x3f));
+                entry->family[family_index++] = (0x80 + ((ch) & 0x3f));
+            }
+
+            family_name += 2;
+            family_length -= 2;
+        }
+
+        entry->family[family_index] = '\0';
+    } else {
+        static const stbtt_uint16 MAC_ROMAN_TABLE[256] = {
+            0x0000, 0x0001, 0x0002, 0x0003, 0x0004, 0x0005, 0x0006, 0x0007,
+            0x0008, 0x0009, 0x000A, 0x000B, 0x000C, 0x000D, 0x000E, 0x000F,
+            0x0010, 0x2318, 0x21E7, 0x2325, 0x2303, 0x0015, 0x0016, 0x0017,
+            0x0018, 0x0019, 0x001A, 0x001B, 0x001C, 0x001D, 0x001E, 0x001F,
+            0x0020, 0x0021, 0x0022, 0x0023, 0x0024, 0x0025, 0x0026, 0x0027,
+            0x0028, 0x0029, 0x002A, 0x002B, 0x002C, 0x002D, 0x002E, 0x002F,
+            0x0030, 0x0031, 0x0032, 0x0033, 0x0034, 0x0035, 0x0036, 0x0037,
+            0x0038, 0x0039, 0x003A, 0x003B, 0x003C, 0x003D, 0x003E, 0x003F,
+            0x0040, 0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046, 0x0047,
+            0x0048, 0x0049, 0x004A, 0x004B, 0x004C, 0x004D, 0x004E, 0x004F,
+            0x0050, 0x0051, 0x0052, 0x0053, 0x0054, 0x0055, 0x0056, 0x0057,
+            0x0058, 0x0059, 0x005A, 0x005B, 0x005C, 0x005D, 0x005E, 0x005F,
+            0x0060, 0x0061, 0x0062, 0x0063, 0x0064, 0x0065, 0x0066, 0x0067,
+            0x0068, 0x0069, 0x006A, 0x006B, 0x006C, 0x006D, 0x006E, 0x006F,
+            0x0070, 0x0071, 0x0072, 0x0073, 0x0074, 0x0075, 0x0076, 0x0077,
+            0x0078, 0x0079, 0x007A, 0x007B, 0x007C, 0x007D, 0x007E, 0x007F,
+            0x00C4, 0x00C5, 0x00C7, 0x00C9, 0x00D1, 0x00D6, 0x00DC, 0x00E1,
+            0x00E0, 0x00E2, 0x00E4, 0x00E3, 0x00E5, 0x00E7, 0x00E9, 0x00E8,
+            0x00EA, 0x00EB, 0x00ED, 0x00EC, 0x00EE, 0x00EF, 0x00F1, 0x00F3,
+            0x00F2, 0x00F4, 0x00F6, 0x00F5, 0x00FA, 0x00F9, 0x00FB, 0x00FC,
+            0x2020, 0x00B0, 0x00A2, 0x00A3, 0x00A7, 0x2022, 0x00B6, 0x00DF,
+            0x00AE, 0x00A9, 0x2122, 0x00B4, 0x00A8, 0x2260, 0x00C6, 0x00D8,
+            0x221E, 0x00B1, 0x2264, 0x2265, 0x00A5, 0x00B5, 0x2202, 0x2211,
+            0x220F, 0x03C0, 0x222B, 0x00AA, 0x00BA, 0x03A9, 0x00E6, 0x00F8,
+            0x00BF, 0x00A1, 0x00AC, 0x221A, 0x0192, 0x2248, 0x2206, 0x00AB,
+            0x00BB, 0x2026, 0x00A0, 0x00C0, 0x00C3, 0x00D5, 0x0152, 0x0153,
+            0x2013, 0x2014, 0x201C, 0x201D, 0x2018, 0x2019, 0x00F7, 0x25CA,
+            0x00FF, 0x0178, 0x2044, 0x20AC, 0x2039, 0x203A, 0xFB01, 0xFB02,
+            0x2021, 0x00B7, 0x201A, 0x201E, 0x2030, 0x00C2, 0x00CA, 0x00C1,
+            0x00CB, 0x00C8, 0x00CD, 0x00CE, 0x00CF, 0x00CC, 0x00D3, 0x00D4,
+            0xF8FF, 0x00D2, 0x00DA, 0x00DB, 0x00D9, 0x0131, 0x02C6, 0x02DC,
+            0x00AF, 0x02D8, 0x02D9, 0x02DA, 0x00B8, 0x02DD, 0x02DB, 0x02C7,
+        };
+
+        const stbtt_uint8* family_name = roman_family_name;
+        while(family_length) {
+            stbtt_uint16 ch = MAC_ROMAN_TABLE[family_name[0]];
+            if(ch < 0x80) {
+                entry->family[family_index++] = ch;
+            } else if(ch < 0x800) {
+                entry->family[family_index++] = (0xc0 + (ch >> 6));
+                entry->family[family_index++] = (0x80 + (ch & 0x3f));
+            } else {
+                entry->family[family_index++] = (0xe0 + (ch >> 12));
+                entry->family[family_index++] = (0x80 + ((ch >> 6) & 0x3f));
+                entry->family[family_index++] = (0x80 + ((ch) & 0x3f));
+            }
+
+            family_name += 1;
+            family_length -= 1;
+        }
+
+        entry->family[family_index] = '\0';
+    }
+
+    entry->face = NULL;
+    entry->data = NULL;
+    entry->bold = false;
+    entry->italic = false;
+    entry->ttcindex = index;
+
+    stbtt_uint32 hd = stbtt__find_table(data, offset, "head");
+    stbtt_uint16 style = ttUSHORT(data + hd + 44);
+    if(style & 0x1)
+        entry->bold = true;
+    if(style & 0x2) {
+        entry->italic = true;
+    }
+
+    return entry;
 }
 
-static void plutovg_unmap(void* data, long length)
+int plutovg_font_face_cache_load_data(plutovg_font_face_cache_t* cache, const void* data, unsigned int length, plutovg_destroy_func_t destroy_func, void* closure)
 {
-    UnmapViewOfFile(data);
+    plutovg_font_data_t* font_data = malloc(sizeof(plutovg_font_data_t));
+    plutovg_init_reference(font_data);
+    font_data->data = data;
+    font_data->length = length;
+    font_data->destroy_func = destroy_func;
+    font_data->closure = closure;
+
+    int num_faces = 0;
+
+    int num_fonts = stbtt_GetNumberOfFonts(data);
+    for(int index = 0; index < num_fonts; ++index) {
+        plutovg_font_face_entry_t* entry = plutovg_font_face_entry_create((stbtt_uint8*)(data), index, NULL);
+        if(entry == NULL)
+            continue;
+        entry->data = plutovg_font_data_reference(font_data);
+        plutovg_font_face_cache_add_entry(cache, entry);
+        num_faces++;
+    }
+
+    plutovg_font_data_destroy(font_data);
+    return num_faces;
 }
 
-#else
+#ifndef PLUTOVG_DISABLE_FONT_FACE_CACHE_LOAD
 
-static void* plutovg_mmap(const char* filename, long* length)
+#include <ctype.h>
+
+/*
+ * The font index is a text file that records the result of scanning font directories, so
+ * later processes can skip parsing every font file. The first line holds the signature,
+ * followed by one record per scanned directory, with tab separated fields:
+ *
+ *   D <mtime> <dirname>
+ *   S <subdirname>
+ *   F <ttcindex> <style> <size> <mtime> <family> <filename>
+ *
+ * A directory record is replayed while the modification time of the directory and the size
+ * and modification time of each of its font files are unchanged, otherwise the directory
+ * is rescanned.
+ */
+
+#define PLUTOVG_FONT_INDEX_SIGNATURE "plutovg-font-index 2"
+
+typedef struct {
+    char* data;
+    int size;
+    int capacity;
+} plutovg_font_index_buffer_t;
+
+typedef struct {
+    plutovg_font_index_buffer_t lines;
+    bool complete;
+} plutovg_font_index_record_t;
+
+typedef struct {
+    const char* dirname;
+    long long mtime;
+    char* lines;
+    int num_lines;
+    bool visited;
+} plutovg_font_index_dir_t;
+
+typedef struct {
+    char* data;
+    plutovg_font_index_dir_t* dirs;
+    int num_dirs;
+    int num_visited;
+    bool changed;
+    plutovg_font_index_buffer_t output;
+} plutovg_font_index_t;
+
+static void plutovg_font_index_buffer_append(plutovg_font_index_buffer_t* buffer, const char* data, size_t length)
 {
-    int fd = open(filename, O_RDONLY);
-    if(fd < 0)
-        return NULL;
-    struct stat st;
-    if(fstat(fd, &st) < 0) {
-        close(fd);
-        return NULL;
-    }
+    plutovg_array_append_data(*buffer, data, (int)(length));
+}
 
-    if(st.st_size == 0) {
-        close(fd);
-        return NULL;
+static bool plutovg_font_index_is_field(const char* data)
+{
+    return strpbrk(data, "\t\r\n") == NULL;
+}
+
+static void plutovg_font_index_add_subdir(plutovg_font_index_record_t* record, const char* dirname)
+{
+    if(!plutovg_font_index_is_field(dirname)) {
+        record->complete = false;
+        return;
     }
 
-    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
-    close(fd);
+    plutovg_font_index_buffer_append(&record->lines, "S\t", 2);
+    plutovg_font_index_buffer_append(&record->lines, dirname, strlen(dirname));
+    plutovg_font_index_buffer_append(&record->lines, "\n", 1);
+}
 
-    if(data == MAP_FAILED)
-        return NULL;
-    *length = st.st_size;
-    return data;
+static void plutovg_font_index_add_face(plutovg_font_index_record_t* record, const plutovg_font_face_entry_t* entry, long long size, long long mtime)
+{
+    if(!plutovg_font_index_is_field(entry->family) || !plutovg_font_index_is_field(entry->filename)) {
+        record->complete = false;
+        return;
+    }
+
+    char buffer[96];
+    int length = snprintf(buffer, sizeof(buffer), "F\t%d\t%d\t%lld\t%lld\t", entry->ttcindex, entry->bold | (entry->italic << 1), size, mtime);
+    plutovg_font_index_buffer_append(&record->lines, buffer, length);
+    plutovg_font_index_buffer_append(&record->lines, entry->family, strlen(entry->family));
+    plutovg_font_index_buffer_append(&record->lines, "\t", 1);
+    plutovg_font_index_buffer_append(&record->lines, entry->filename, strlen(entry->filename));
+    plutovg_font_index_buffer_append(&record->lines, "\n", 1);
 }
 
-static void plutovg_unmap(void* data, long length)
+static void plutovg_font_index_add_record(plutovg_font_index_t* index, const char* dirname, long long mtime, const char* lines, size_t length)
 {
-    munmap(data, length);
+    char buffer[64];
+    int buffer_length = snprintf(buffer, sizeof(buffer), "D\t%lld\t", mtime);
+    plutovg_font_index_buffer_append(&index->output, buffer, buffer_length);
+    plutovg_font_index_buffer_append(&index->output, dirname, strlen(dirname));
+    plutovg_font_index_buffer_append(&index->output, "\n", 1);
+    plutovg_font_index_buffer_append(&index->output, lines, length);
 }
 
-#endif // _WIN32
+static int plutovg_font_index_dir_compare(const void* a, const void* b)
+{
+    const plutovg_font_index_dir_t* a_dir = a;
+    const plutovg_font_index_dir_t* b_dir = b;
+    return strcmp(a_dir->dirname, b_dir->dirname);
+}
 
-int plutovg_font_face_cache_load_file(plutovg_font_face_cache_t* cache, const char* filename)
+static void plutovg_font_index_init(plutovg_font_index_t* index, const char* filename)
 {
-    long length;
-    stbtt_uint8* data = plutovg_mmap(filename, &length);
-    if(data == NULL) {
-        return 0;
+    index->data = NULL;
+    index->dirs = NULL;
+    index->num_dirs = 0;
+    index->num_visited = 0;
+    index->changed = false;
+    plutovg_array_init(index->output);
+
+    FILE* fp = fopen(filename, "rb");
+    if(fp == NULL) {
+        index->changed = true;
+        return;
     }
 
-    int num_faces = 0;
+    long length = -1;
+    if(fseek(fp, 0, SEEK_END) == 0) {
+        length = ftell(fp);
+        fseek(fp, 0, SEEK_SET);
+    }
 
-    int num_fonts = stbtt_GetNumberOfFonts(data);
-    for(int index = 0; index < num_fonts; ++index) {
-        int offset = stbtt_GetFontOffsetForIndex(data, index);
-        if(offset == -1 || !stbtt__isfont(data + offset)) {
-            continue;
+    if(length > 0) {
+        index->data = malloc(length + 1);
+        if(fread(index->data, 1, length, fp) != (size_t)(length)) {
+            length = -1;
         }
+    }
 
-        stbtt_uint32 nm = stbtt__find_table(data, offset, "name");
-        stbtt_uint16 nm_count = ttUSHORT(data + nm + 2);
+    fclose(fp);
+    if(length <= 0)
+        goto invalid;
+    char* line = index->data;
+    char* end = index->data + length;
+    int capacity = 0;
+    while(line < end) {
+        char* next = memchr(line, '\n', end - line);
+        if(next == NULL)
+            break;
+        *next = '\0';
+        if(line == index->data) {
+            if(strcmp(line, PLUTOVG_FONT_INDEX_SIGNATURE))
+                goto invalid;
+        } else if(line[0] == 'D' && line[1] == '\t') {
+            char* dirname;
+            long long mtime = strtoll(line + 2, &dirname, 10);
+            if(*dirname++ != '\t')
+                goto invalid;
+            if(index->num_dirs >= capacity) {
+                capacity = capacity == 0 ? 64 : capacity << 1;
+                index->dirs = realloc(index->dirs, capacity * sizeof(plutovg_font_index_dir_t));
+            }
 
-        const stbtt_uint8* unicode_family_name = NULL;
-        const stbtt_uint8* roman_family_name = NULL;
+            plutovg_font_index_dir_t* dir = &index->dirs[index->num_dirs++];
+            dir->dirname = dirname;
+            dir->mtime = mtime;
+            dir->lines = next + 1;
+            dir->num_lines = 0;
+            dir->visited = false;
+        } else if(index->num_dirs == 0) {
+            goto invalid;
+        } else {
+            index->dirs[index->num_dirs - 1].num_lines++;
+        }
 
-        size_t family_length = 0;
-        for(stbtt_int32 i = 0; i < nm_count; ++i) {
-            stbtt_uint32 loc = nm + 6 + 12 * i;
-            stbtt_uint16 nm_id = ttUSHORT(data + loc + 6);
-            if(nm_id != 1) {
-                continue;
-            }
+        line = next + 1;
+    }
 
-            stbtt_uint16 platform = ttUSHORT(data + loc + 0);
-            stbtt_uint16 encoding = ttUSHORT(data + loc + 2);
+    qsort(index->dirs, index->num_dirs, sizeof(plutovg_font_index_dir_t), plutovg_font_index_dir_compare);
+    return;
+invalid:
+    free(index->data);
+    free(index->dirs);
+    index->data = NULL;
+    index->dirs = NULL;
+    index->num_dirs = 0;
+    index->changed = true;
+}
 
-            const stbtt_uint8* family_name = data + nm + ttUSHORT(data + nm + 4) + ttUSHORT(data + loc + 10);
-            if(platform == 1 && encoding == 0) {
-                family_length = ttUSHORT(data + loc + 8);
-                roman_family_name = family_name;
-                continue;
-            }
+static void plutovg_font_index_save(plutovg_font_index_t* index, const char* filename)
+{
+    if(!index->changed && index->num_visited == index->num_dirs)
+        return;
+    size_t filename_length = strlen(filename);
+    char* tmpname = malloc(filename_length + 32);
+#ifdef _WIN32
+    snprintf(tmpname, filename_length + 32, "%s.%lu.tmp", filename, (unsigned long)(GetCurrentProcessId()));
+#else
+    snprintf(tmpname, filename_length + 32, "%s.%ld.tmp", filename, (long)(getpid()));
+#endif
+
+    FILE* fp = fopen(tmpname, "wb");
+    if(fp == NULL) {
+        free(tmpname);
+        return;
+    }
+
+    bool success = fputs(PLUTOVG_FONT_INDEX_SIGNATURE "\n", fp) >= 0;
+    if(success && index->output.size > 0)
+        success = fwrite(index->output.data, 1, index->output.size, fp) == (size_t)(index->output.size);
+    success = fclose(fp) == 0 && success;
+#ifdef _WIN32
+    success = success && MoveFileExA(tmpname, filename, MOVEFILE_REPLACE_EXISTING);
+#else
+    success = success && rename(tmpname, filename) == 0;
+#endif
+    if(!success)
+        remove(tmpname);
+    free(tmpname);
+}
+
+static void plutovg_font_index_destroy(plutovg_font_index_t* index)
+{
+    plutovg_array_destroy(index->output);
+    free(index->dirs);
+    free(index->data);
+}
+
+static plutovg_font_index_dir_t* plutovg_font_index_find_dir(plutovg_font_index_t* index, const char* dirname)
+{
+    plutovg_font_index_dir_t dir_key;
+    dir_key.dirname = dirname;
+    return bsearch(&dir_key, index->dirs, index->num_dirs, sizeof(plutovg_font_index_dir_t), plutovg_font_index_dir_compare);
+}
+
+static bool plutovg_font_index_stat(const char* path, bool directory, long long* size, long long* mtime)
+{
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if(!GetFileAttributesExA(path, GetFileExInfoStandard, &data) || !(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != !directory)
+        return false;
+    *size = ((long long)(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+    *mtime = ((long long)(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+#else
+    struct stat st;
+    if(stat(path, &st) == -1 || !S_ISDIR(st.st_mode) != !directory)
+        return false;
+    *size = st.st_size;
+#if defined(__APPLE__)
+    *mtime = (long long)(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#elif defined(__linux__)
+    *mtime = (long long)(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#else
+    *mtime = st.st_mtime;
+#endif
+#endif
+    return true;
+}
 
-            if(platform == 0 || (platform == 3 && encoding == 1) || (platform == 3 && encoding == 10)) {
-                family_length = ttUSHORT(data + loc + 8);
-                unicode_family_name = family_name;
-                break;
+typedef struct {
+    long ttcindex;
+    long style;
+    long long size;
+    long long mtime;
+    const char* family;
+    size_t family_length;
+    const char* filename;
+} plutovg_font_index_face_t;
+
+static bool plutovg_font_index_parse_face(const char* line, plutovg_font_index_face_t* face)
+{
+    char* data;
+    face->ttcindex = strtol(line + 2, &data, 10);
+    if(*data++ != '\t')
+        return false;
+    face->style = strtol(data, &data, 10);
+    if(*data++ != '\t')
+        return false;
+    face->size = strtoll(data, &data, 10);
+    if(*data++ != '\t')
+        return false;
+    face->mtime = strtoll(data, &data, 10);
+    if(*data++ != '\t')
+        return false;
+    face->family = data;
+    face->filename = strchr(face->family, '\t');
+    if(face->filename == NULL)
+        return false;
+    face->family_length = face->filename++ - face->family;
+    return true;
+}
+
+static bool plutovg_font_index_dir_is_valid(const plutovg_font_index_dir_t* dir)
+{
+    const char* filename = NULL;
+    const char* line = dir->lines;
+    for(int i = 0; i < dir->num_lines; ++i) {
+        plutovg_font_index_face_t face;
+        if(line[0] == 'F' && line[1] == '\t' && plutovg_font_index_parse_face(line, &face)) {
+            // faces of a collection are recorded one after another
+            if(filename == NULL || strcmp(filename, face.filename)) {
+                long long size, mtime;
+                if(!plutovg_font_index_stat(face.filename, false, &size, &mtime) || size != face.size || mtime != face.mtime)
+                    return false;
+                filename = face.filename;
             }
         }
 
-        if(unicode_family_name == NULL && roman_family_name == NULL)
-            continue;
-        size_t filename_length = strlen(filename) + 1;
-        size_t max_family_length = (unicode_family_name ? 3 * (family_length / 2) : family_length * 3) + 1;
+        line += strlen(line) + 1;
+    }
 
-        plutovg_font_face_entry_t* entry = malloc(max_family_length + filename_length + sizeof(plutovg_font_face_entry_t));
-        entry->family = (char*)(entry + 1);
-        entry->filename = entry->family + max_family_length;
-        memcpy(entry->filename, filename, filename_length);
+    return true;
+}
 
-        size_t family_index = 0;
-        if(unicode_family_name) {
-            const stbtt_uint8* family_name = unicode_family_name;
-            while(family_length) {
-                stbtt_uint16 ch = family_name[0] * 256 + family_name[1];
-                if(ch < 0x80) {
-                    entry->family[family_index++] = ch;
-                } else if(ch < 0x800) {
-                    entry->family[family_index++] = (0xc0 + (ch >> 6));
-                    entry->family[family_index++] = (0x80 + (ch & 0x3f));
-                } else if(ch >= 0xd800 && ch < 0xdc00) {
-                    stbtt_uint16 ch2 = family_name[2] * 256 + family_name[3];
-                    stbtt_uint32 c = ((ch - 0xd800) << 10) + (ch2 - 0xdc00) + 0x10000;
-
-                    entry->family[family_index++] = (0xf0 + (c >> 18));
-                    entry->family[family_index++] = (0x80 + ((c >> 12) & 0x3f));
-                    entry->family[family_index++] = (0x80 + ((c >> 6) & 0x3f));
-                    entry->family[family_index++] = (0x80 + ((c) & 0x3f));
-
-                    family_name += 2;
-                    family_length -= 2;
-                } else {
-                    entry->family[family_index++] = (0xe0 + (ch >> 12));
-                    entry->family[family_index++] = (0x80 + ((ch >> 6) & 0x3f));
-                    entry->family[family_index++] = (0x80 + ((ch) & 0x3f));
-                }
+static bool plutovg_font_face_cache_add_index_entry(plutovg_font_face_cache_t* cache, const char* line)
+{
+    plutovg_font_index_face_t face;
+    if(!plutovg_font_index_parse_face(line, &face))
+        return false;
+    size_t filename_length = strlen(face.filename) + 1;
 
-                family_name += 2;
-                family_length -= 2;
-            }
+    plutovg_font_face_entry_t* entry = malloc(face.family_length + 1 + filename_length + sizeof(plutovg_font_face_entry_t));
+    entry->face = NULL;
+    entry->data = NULL;
+    entry->family = (char*)(entry + 1);
+    entry->filename = entry->family + face.family_length + 1;
+    memcpy(entry->family, face.family, face.family_length);
+    entry->family[face.family_length] = '\0';
+    memcpy(entry->filename, face.filename, filename_length);
 
-            entry->family[family_index] = '\0';
-        } else {
-            static const stbtt_uint16 MAC_ROMAN_TABLE[256] = {
-                0x0000, 0x0001, 0x0002, 0x0003, 0x0004, 0x0005, 0x0006, 0x0007,
-                0x0008, 0x0009, 0x000A, 0x000B, 0x000C, 0x000D, 0x000E, 0x000F,
-                0x0010, 0x2318, 0x21E7, 0x2325, 0x2303, 0x0015, 0x0016, 0x0017,
-                0x0018, 0x0019, 0x001A, 0x001B, 0x001C, 0x001D, 0x001E, 0x001F,
-                0x0020, 0x0021, 0x0022, 0x0023, 0x0024, 0x0025, 0x0026, 0x0027,
-                0x0028, 0x0029, 0x002A, 0x002B, 0x002C, 0x002D, 0x002E, 0x002F,
-                0x0030, 0x0031, 0x0032, 0x0033, 0x0034, 0x0035, 0x0036, 0x0037,
-                0x0038, 0x0039, 0x003A, 0x003B, 0x003C, 0x003D, 0x003E, 0x003F,
-                0x0040, 0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046, 0x0047,
-                0x0048, 0x0049, 0x004A, 0x004B, 0x004C, 0x004D, 0x004E, 0x004F,
-                0x0050, 0x0051, 0x0052, 0x0053, 0x0054, 0x0055, 0x0056, 0x0057,
-                0x0058, 0x0059, 0x005A, 0x005B, 0x005C, 0x005D, 0x005E, 0x005F,
-                0x0060, 0x0061, 0x0062, 0x0063, 0x0064, 0x0065, 0x0066, 0x0067,
-                0x0068, 0x0069, 0x006A, 0x006B, 0x006C, 0x006D, 0x006E, 0x006F,
-                0x0070, 0x0071, 0x0072, 0x0073, 0x0074, 0x0075, 0x0076, 0x0077,
-                0x0078, 0x0079, 0x007A, 0x007B, 0x007C, 0x007D, 0x007E, 0x007F,
-                0x00C4, 0x00C5, 0x00C7, 0x00C9, 0x00D1, 0x00D6, 0x00DC, 0x00E1,
-                0x00E0, 0x00E2, 0x00E4, 0x00E3, 0x00E5, 0x00E7, 0x00E9, 0x00E8,
-                0x00EA, 0x00EB, 0x00ED, 0x00EC, 0x00EE, 0x00EF, 0x00F1, 0x00F3,
-                0x00F2, 0x00F4, 0x00F6, 0x00F5, 0x00FA, 0x00F9, 0x00FB, 0x00FC,
-                0x2020, 0x00B0, 0x00A2, 0x00A3, 0x00A7, 0x2022, 0x00B6, 0x00DF,
-                0x00AE, 0x00A9, 0x2122, 0x00B4, 0x00A8, 0x2260, 0x00C6, 0x00D8,
-                0x221E, 0x00B1, 0x2264, 0x2265, 0x00A5, 0x00B5, 0x2202, 0x2211,
-                0x220F, 0x03C0, 0x222B, 0x00AA, 0x00BA, 0x03A9, 0x00E6, 0x00F8,
-                0x00BF, 0x00A1, 0x00AC, 0x221A, 0x0192, 0x2248, 0x2206, 0x00AB,
-                0x00BB, 0x2026, 0x00A0, 0x00C0, 0x00C3, 0x00D5, 0x0152, 0x0153,
-                0x2013, 0x2014, 0x201C, 0x201D, 0x2018, 0x2019, 0x00F7, 0x25CA,
-                0x00FF, 0x0178, 0x2044, 0x20AC, 0x2039, 0x203A, 0xFB01, 0xFB02,
-                0x2021, 0x00B7, 0x201A, 0x201E, 0x2030, 0x00C2, 0x00CA, 0x00C1,
-                0x00CB, 0x00C8, 0x00CD, 0x00CE, 0x00CF, 0x00CC, 0x00D3, 0x00D4,
-                0xF8FF, 0x00D2, 0x00DA, 0x00DB, 0x00D9, 0x0131, 0x02C6, 0x02DC,
-                0x00AF, 0x02D8, 0x02D9, 0x02DA, 0x00B8, 0x02DD, 0x02DB, 0x02C7,
-            };
-
-            const stbtt_uint8* family_name = roman_family_name;
-            while(family_length) {
-                stbtt_uint16 ch = MAC_ROMAN_TABLE[family_name[0]];
-                if(ch < 0x80) {
-                    entry->family[family_index++] = ch;
-                } else if(ch < 0x800) {
-                    entry->family[family_index++] = (0xc0 + (ch >> 6));
-                    entry->family[family_index++] = (0x80 + (ch & 0x3f));
-                } else {
-                    entry->family[family_index++] = (0xe0 + (ch >> 12));
-                    entry->family[family_index++] = (0x80 + ((ch >> 6) & 0x3f));
-                    entry->family[family_index++] = (0x80 + ((ch) & 0x3f));
-                }
+    entry->ttcindex = face.ttcindex;
+    entry->bold = face.style & 0x1;
+    entry->italic = face.style & 0x2;
 
-                family_name += 1;
-                family_length -= 1;
-            }
+    plutovg_font_face_cache_add_entry(cache, entry);
+    return true;
+}
 
-            entry->family[family_index] = '\0';
-        }
+static int plutovg_font_face_cache_load_file_internal(plutovg_font_face_cache_t* cache, const char* filename, plutovg_font_index_record_t* record)
+{
+    long length;
+    stbtt_uint8* data = plutovg_mmap(filename, &length);
+    if(data == NULL) {
+        return 0;
+    }
 
-        entry->face = NULL;
-        entry->bold = false;
-        entry->italic = false;
-        entry->ttcindex = index;
-
-        stbtt_uint32 hd = stbtt__find_table(data, offset, "head");
-        stbtt_uint16 style = ttUSHORT(data + hd + 44);
-        if(style & 0x1)
-            entry->bold = true;
-        if(style & 0x2) {
-            entry->italic = true;
-        }
+    long long size, mtime;
+    if(record && !plutovg_font_index_stat(filename, false, &size, &mtime)) {
+        record->complete = false;
+        record = NULL;
+    }
 
+    int num_faces = 0;
+
+    int num_fonts = stbtt_GetNumberOfFonts(data);
+    for(int index = 0; index < num_fonts; ++index) {
+        plutovg_font_face_entry_t* entry = plutovg_font_face_entry_create(data, index, filename);
+        if(entry == NULL)
+            continue;
         plutovg_font_face_cache_add_entry(cache, entry);
+        if(record) {
+            plutovg_font_index_add_face(record, entry, size, mtime);
+        }
+
         num_faces++;
     }
 
@@ -938,6 +2066,11 @@ int plutovg_font_face_cache_load_file(plutovg_font_face_cache_t* cache, const ch
     return num_faces;
 }
 
+int plutovg_font_face_cache_load_file(plutovg_font_face_cache_t* cache, const char* filename)
+{
+    return plutovg_font_face_cache_load_file_internal(cache, filename, NULL);
+}
+
 static bool plutovg_font_face_supports_file(const char* filename)
 {
     const char* extension = strrchr(filename, '.');
@@ -958,9 +2091,11 @@ static bool plutovg_font_face_supports_file(const char* filename)
     return false;
 }
 
+static int plutovg_font_face_cache_load_dir_internal(plutovg_font_face_cache_t* cache, const char* dirname, plutovg_font_index_t* index);
+
 #ifdef _WIN32
 
-int plutovg_font_face_cache_load_dir(plutovg_font_face_cache_t* cache, const char* dirname)
+static int plutovg_font_face_cache_scan_dir(plutovg_font_face_cache_t* cache, const char* dirname, plutovg_font_index_t* index, plutovg_font_index_record_t* record)
 {
     char search_path[MAX_PATH];
     snprintf(search_path, sizeof(search_path), "%s\\*", dirname);
@@ -981,9 +2116,11 @@ int plutovg_font_face_cache_load_dir(plutovg_font_face_cache_t* cache, const cha
         snprintf(path, sizeof(path), "%s\\%s", dirname, name);
 
         if(find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
-            num_faces += plutovg_font_face_cache_load_dir(cache, path);
+            if(record)
+                plutovg_font_index_add_subdir(record, path);
+            num_faces += plutovg_font_face_cache_load_dir_internal(cache, path, index);
         } else if(plutovg_font_face_supports_file(path)) {
-            num_faces += plutovg_font_face_cache_load_file(cache, path);
+            num_faces += plutovg_font_face_cache_load_file_internal(cache, path, record);
         }
     } while(FindNextFileA(handle, &find_data));
 
@@ -993,7 +2130,7 @@ int plutovg_font_face_cache_load_dir(plutovg_font_face_cache_t* cache, const cha
 
 #else
 
-int plutovg_font_face_cache_load_dir(plutovg_font_face_cache_t* cache, const char* dirname)
+static int plutovg_font_face_cache_scan_dir(plutovg_font_face_cache_t* cache, const char* dirname, plutovg_font_index_t* index, plutovg_font_index_record_t* record)
 {
     DIR* dir = opendir(dirname);
     if(dir == NULL) {
@@ -1013,9 +2150,11 @@ int plutovg_font_face_cache_load_dir(plutovg_font_face_cache_t* cache, const cha
         if(stat(path, &st) == -1)
             continue;
         if(S_ISDIR(st.st_mode)) {
-            num_faces += plutovg_font_face_cache_load_dir(cache, path);
+            if(record)
+                plutovg_font_index_add_subdir(record, path);
+            num_faces += plutovg_font_face_cache_load_dir_internal(cache, path, index);
         } else if(S_ISREG(st.st_mode) && plutovg_font_face_supports_file(path)) {
-            num_faces += plutovg_font_face_cache_load_file(cache, path);
+            num_faces += plutovg_font_face_cache_load_file_internal(cache, path, record);
         }
     }
 
@@ -1025,19 +2164,122 @@ int plutovg_font_face_cache_load_dir(plutovg_font_face_cache_t* cache, const cha
 
 #endif // _WIN32
 
-int plutovg_font_face_cache_load_sys(plutovg_font_face_cache_t* cache)
+static int plutovg_font_face_cache_replay_dir(plutovg_font_face_cache_t* cache, plutovg_font_index_dir_t* dir, plutovg_font_index_t* index)
 {
+    plutovg_font_index_add_record(index, dir->dirname, dir->mtime, NULL, 0);
+
     int num_faces = 0;
+
+    const char* line = dir->lines;
+    for(int i = 0; i < dir->num_lines; ++i) {
+        size_t length = strlen(line);
+        if(line[0] == 'F' && line[1] == '\t') {
+            if(plutovg_font_face_cache_add_index_entry(cache, line)) {
+                plutovg_font_index_buffer_append(&index->output, line, length);
+                plutovg_font_index_buffer_append(&index->output, "\n", 1);
+                num_faces++;
+            }
+        } else if(line[0] == 'S' && line[1] == '\t') {
+            plutovg_font_index_buffer_append(&index->output, line, length);
+            plutovg_font_index_buffer_append(&index->output, "\n", 1);
+        }
+
+        line += length + 1;
+    }
+
+    line = dir->lines;
+    for(int i = 0; i < dir->num_lines; ++i) {
+        if(line[0] == 'S' && line[1] == '\t')
+            num_faces += plutovg_font_face_cache_load_dir_internal(cache, line + 2, index);
+        line += strlen(line) + 1;
+    }
+
+    return num_faces;
+}
+
+static int plutovg_font_face_cache_load_dir_internal(plutovg_font_face_cache_t* cache, const char* dirname, plutovg_font_index_t* index)
+{
+    if(index == NULL)
+        return plutovg_font_face_cache_scan_dir(cache, dirname, NULL, NULL);
+    long long size, mtime;
+    if(!plutovg_font_index_stat(dirname, true, &size, &mtime))
+        return 0;
+    plutovg_font_index_dir_t* dir = plutovg_font_index_find_dir(index, dirname);
+    if(dir && dir->visited)
+        return 0;
+    if(dir) {
+        dir->visited = true;
+        index->num_visited++;
+        if(dir->mtime == mtime && plutovg_font_index_dir_is_valid(dir)) {
+            return plutovg_font_face_cache_replay_dir(cache, dir, index);
+        }
+    }
+
+    plutovg_font_index_record_t record;
+    plutovg_array_init(record.lines);
+    record.complete = true;
+
+    int num_faces = plutovg_font_face_cache_scan_dir(cache, dirname, index, &record);
+    if(record.complete)
+        plutovg_font_index_add_record(index, dirname, mtime, record.lines.data, record.lines.size);
+    plutovg_array_destroy(record.lines);
+    index->changed = true;
+    return num_faces;
+}
+
+static int plutovg_font_face_cache_load_dirs(plutovg_font_face_cache_t* cache, const char* const* dirnames, const char* index_filename)
+{
+    if(index_filename == NULL) {
+        int num_faces = 0;
+        for(int i = 0; dirnames[i]; ++i)
+            num_faces += plutovg_font_face_cache_load_dir_internal(cache, dirnames[i], NULL);
+        return num_faces;
+    }
+
+    plutovg_font_index_t index;
+    plutovg_font_index_init(&index, index_filename);
+
+    int num_faces = 0;
+    for(int i = 0; dirnames[i]; ++i)
+        num_faces += plutovg_font_face_cache_load_dir_internal(cache, dirnames[i], &index);
+    plutovg_font_index_save(&index, index_filename);
+    plutovg_font_index_destroy(&index);
+    return num_faces;
+}
+
+int plutovg_font_face_cache_load_dir(plutovg_font_face_cache_t* cache, const char* dirname)
+{
+    const char* dirnames[] = {dirname, NULL};
+    return plutovg_font_face_cache_load_dirs(cache, dirnames, NULL);
+}
+
+int plutovg_font_face_cache_load_dir_with_index(plutovg_font_face_cache_t* cache, const char* dirname, const char* index_filename)
+{
+    const char* dirnames[] = {dirname, NULL};
+    return plutovg_font_face_cache_load_dirs(cache, dirnames, index_filename);
+}
+
+static const char* const plutovg_sys_font_dirs[] = {
 #if defined(_WIN32)
-    num_faces += plutovg_font_face_cache_load_dir(cache, "C:\\Windows\\Fonts");
+    "C:\\Windows\\Fonts",
 #elif defined(__APPLE__)
-    num_faces += plutovg_font_face_cache_load_dir(cache, "/Library/Fonts");
-    num_faces += plutovg_font_face_cache_load_dir(cache, "/System/Library/Fonts");
+    "/Library/Fonts",
+    "/System/Library/Fonts",
 #elif defined(__linux__)
-    num_faces += plutovg_font_face_cache_load_dir(cache, "/usr/share/fonts");
-    num_faces += plutovg_font_face_cache_load_dir(cache, "/usr/local/share/fonts");
+    "/usr/share/fonts",
+    "/usr/local/share/fonts",
 #endif
-    return num_faces;
+    NULL
+};
+
+int plutovg_font_face_cache_load_sys(plutovg_font_face_cache_t* cache)
+{
+    return plutovg_font_face_cache_load_dirs(cache, plutovg_sys_font_dirs, NULL);
+}
+
+int plutovg_font_face_cache_load_sys_with_index(plutovg_font_face_cache_t* cache, const char* index_filename)
+{
+    return plutovg_font_face_cache_load_dirs(cache, plutovg_sys_font_dirs, index_filename);
 }
 
 #else
@@ -1052,9 +2294,19 @@ int plutovg_font_face_cache_load_dir(plutovg_font_face_cache_t* cache, const cha
     return -1;
 }
 
+int plutovg_font_face_cache_load_dir_with_index(plutovg_font_face_cache_t* cache, const char* dirname, const char* index_filename)
+{
+    return -1;
+}
+
 int plutovg_font_face_cache_load_sys(plutovg_font_face_cache_t* cache)
 {
     return -1;
 }
 
+int plutovg_font_face_cache_load_sys_with_index(plutovg_font_face_cache_t* cache, const char* index_filename)
+{
+    return -1;
+}
+
 #endif // PLUTOVG_DISABLE_FONT_FACE_CACHE_LOAD
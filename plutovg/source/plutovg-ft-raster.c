@@ -81,6 +81,7 @@ typedef ptrdiff_t  PVG_FT_PtrDist;
 #include <limits.h>
 
 #define PVG_FT_MINIMUM_POOL_SIZE 8192
+#define PVG_FT_MAXIMUM_POOL_SIZE (4 * 1024 * 1024)
 
 #define RAS_ARG   PWorker  worker
 #define RAS_ARG_  PWorker  worker,
@@ -173,6 +174,8 @@ PVG_FT_END_STMNT
     PVG_FT_PtrDist     num_cells;
 
     TPos    x,  y;
+    TPos    flatness;
+    int     flatness_set;
 
     PVG_FT_Outline  outline;
     PVG_FT_BBox     clip_box;
@@ -189,6 +192,7 @@ PVG_FT_END_STMNT
 
     int  band_size;
     int  band_shoot;
+    int  num_passes;
 
     pvg_ft_jmp_buf  jump_buffer;
 
@@ -1015,7 +1019,7 @@ PVG_FT_END_STMNT
     /* each bisection predictably reduces deviation exactly 4-fold. */
     /* Even 32-bit deviation would vanish after 16 bisections.      */
     draw = 1;
-    while ( dx > ONE_PIXEL / 4 )
+    while ( dx > ras.flatness * 2 )
     {
       dx >>= 2;
       draw <<= 1;
@@ -1108,6 +1112,20 @@ PVG_FT_END_STMNT
       return;
     }
 
+    /* an arc whose control points all lie within an explicit flatness */
+    /* of its start cannot deviate visibly from its chord              */
+    if ( ras.flatness_set                                  &&
+         PVG_FT_ABS( arc[0].x - arc[3].x ) <= ras.flatness &&
+         PVG_FT_ABS( arc[0].y - arc[3].y ) <= ras.flatness &&
+         PVG_FT_ABS( arc[1].x - arc[3].x ) <= ras.flatness &&
+         PVG_FT_ABS( arc[1].y - arc[3].y ) <= ras.flatness &&
+         PVG_FT_ABS( arc[2].x - arc[3].x ) <= ras.flatness &&
+         PVG_FT_ABS( arc[2].y - arc[3].y ) <= ras.flatness )
+    {
+      gray_line_to( RAS_VAR_ arc[0].x, arc[0].y );
+      return;
+    }
+
     for (;;)
     {
       /* Decide whether to split or draw. See `Rapid Termination          */
@@ -1127,7 +1145,7 @@ PVG_FT_END_STMNT
         goto Split;
 
       /* Max deviation may be as much as (s/L) * 3/4 (if Hain's v = 1). */
-      s_limit = L * (TPos)( ONE_PIXEL / 6 );
+      s_limit = L * ( ras.flatness * 4 / 3 );
 
       /* s is L * the perpendicular distance from P1 to the line P0-P3. */
       dx1 = arc[1].x - arc[0].x;
@@ -1765,6 +1783,7 @@ void PVG_FT_Outline_Get_CBox(const PVG_FT_Outline* outline, PVG_FT_BBox* acbox)
         ras.count_ey  = band->max - band->min;
 
         error = gray_convert_glyph_inner( RAS_VAR );
+        ras.num_passes++;
 
         if ( !error )
         {
@@ -1861,32 +1880,75 @@ void PVG_FT_Outline_Get_CBox(const PVG_FT_Outline* outline, PVG_FT_BBox* acbox)
     ras.num_cells = 0;
     ras.invalid   = 1;
     ras.band_size = (int)(buffer_size / (long)(sizeof(TCell) * 8));
+    ras.num_passes = 0;
 
     ras.render_span      = (PVG_FT_Raster_Span_Func)params->gray_spans;
     ras.render_span_data = params->user;
 
+    ras.flatness_set = params->flatness > 0;
+    if ( ras.flatness_set )
+      ras.flatness = UPSCALE( params->flatness );
+    else
+      ras.flatness = ONE_PIXEL / 8;
+
     return gray_convert_glyph( RAS_VAR );
   }
 
-  void
-  PVG_FT_Raster_Render(const PVG_FT_Raster_Params *params)
+  /* replaces the pool memory, keeping the old buffer when allocation fails */
+  static int
+  gray_pool_resize( PVG_FT_Raster_Pool*  pool,
+                    long                 size )
+  {
+      void* buffer = malloc(size);
+      if(buffer == NULL)
+          return 0;
+      free(pool->buffer);
+      pool->buffer = buffer;
+      pool->size = size;
+      return 1;
+  }
+
+  int
+  PVG_FT_Raster_Render(const PVG_FT_Raster_Params *params, PVG_FT_Raster_Pool *pool)
   {
       char stack[PVG_FT_MINIMUM_POOL_SIZE];
-      size_t length = PVG_FT_MINIMUM_POOL_SIZE;
+      void* buffer = stack;
+      long length = PVG_FT_MINIMUM_POOL_SIZE;
+      if(pool && pool->size > length) {
+          buffer = pool->buffer;
+          length = pool->size;
+      }
 
       TWorker worker;
       worker.skip_spans = 0;
+      worker.num_passes = 0;
       int rendered_spans = 0;
-      int error = gray_raster_render(&worker, stack, length, params);
+      int error = gray_raster_render(&worker, buffer, length, params);
       while(error == ErrRaster_OutOfMemory) {
           if(worker.skip_spans < 0)
               rendered_spans += -worker.skip_spans;
           worker.skip_spans = rendered_spans;
           length *= 2;
-          void* heap = malloc(length);
-          error = gray_raster_render(&worker, heap, length, params);
-          free(heap);
+          if(pool) {
+              if(!gray_pool_resize(pool, length))
+                  return ErrRaster_OutOfMemory;
+              error = gray_raster_render(&worker, pool->buffer, pool->size, params);
+          } else {
+              void* heap = malloc(length);
+              if(heap == NULL)
+                  return ErrRaster_OutOfMemory;
+              error = gray_raster_render(&worker, heap, length, params);
+              free(heap);
+          }
+      }
+
+      /* grow the pool when the outline had to be split into bands, */
+      /* so the next outline of this size renders in a single pass  */
+      if(pool && worker.num_passes > 1 && length < PVG_FT_MAXIMUM_POOL_SIZE) {
+          gray_pool_resize(pool, length * 2);
       }
+
+      return error;
   }
 
 /* END */
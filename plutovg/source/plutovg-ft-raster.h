@@ -386,6 +386,11 @@ typedef void
 /*                   should be expressed in _integer_ pixels (and not in */
 /*                   26.6 fixed-point units).                            */
 /*                                                                       */
+/*    flatness    :: The maximum distance between a curve and the lines  */
+/*                   approximating it, in 26.6 fixed-point units.  Zero  */
+/*                   selects the default of 1/8 pixel; only an explicit  */
+/*                   flatness draws tiny cubics as single lines.         */
+/*                                                                       */
 /* <Note>                                                                */
 /*    An anti-aliased glyph bitmap is drawn if the @PVG_FT_RASTER_FLAG_AA    */
 /*    bit flag is set in the `flags' field, otherwise a monochrome       */
@@ -410,11 +415,49 @@ typedef struct  PVG_FT_Raster_Params_
     PVG_FT_SpanFunc          gray_spans;
     void*                   user;
     PVG_FT_BBox              clip_box;
+    PVG_FT_Pos               flatness;
 
 } PVG_FT_Raster_Params;
 
 
-void
-PVG_FT_Raster_Render(const PVG_FT_Raster_Params *params);
+/*************************************************************************/
+/*                                                                       */
+/* <Struct>                                                              */
+/*    PVG_FT_Raster_Pool                                                     */
+/*                                                                       */
+/* <Description>                                                         */
+/*    A render pool that is kept across calls to PVG_FT_Raster_Render.       */
+/*    The pool grows to the size needed to render an outline in a single */
+/*    pass, so later outlines of similar complexity neither re-render    */
+/*    nor allocate.  A zeroed pool is valid; release `buffer' with free. */
+/*                                                                       */
+/* <Fields>                                                              */
+/*    buffer :: The pool memory, or NULL.                                */
+/*                                                                       */
+/*    size   :: The size of the pool memory in bytes.                    */
+/*                                                                       */
+typedef struct  PVG_FT_Raster_Pool_
+{
+    void*  buffer;
+    long   size;
+
+} PVG_FT_Raster_Pool;
+
+
+/*************************************************************************/
+/*                                                                       */
+/* <Function>                                                            */
+/*    PVG_FT_Raster_Render                                                   */
+/*                                                                       */
+/* <Description>                                                         */
+/*    Renders an outline, growing `pool' (if any) as needed.             */
+/*                                                                       */
+/* <Return>                                                              */
+/*    Zero on success, or a negative error code.  When the rasterizer    */
+/*    runs out of memory, spans already emitted are kept and `pool'      */
+/*    retains its previous buffer.                                       */
+/*                                                                       */
+int
+PVG_FT_Raster_Render(const PVG_FT_Raster_Params *params, PVG_FT_Raster_Pool *pool);
 
 #endif // PLUTOVG_FT_RASTER_H
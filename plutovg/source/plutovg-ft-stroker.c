@@ -618,6 +618,7 @@ typedef struct PVG_FT_StrokerRec_ {
     PVG_FT_Vector subpath_start;       /* subpath start position */
     PVG_FT_Fixed  subpath_line_length; /* subpath start lineto len */
     PVG_FT_Bool   handle_wide_strokes; /* use wide strokes logic? */
+    PVG_FT_Byte   subpath_seams;       /* seam bits of the open subpath */
 
     PVG_FT_Stroker_LineCap  line_cap;
     PVG_FT_Stroker_LineJoin line_join;
@@ -711,11 +712,12 @@ static PVG_FT_Error ft_stroker_arcto(PVG_FT_Stroker stroker, PVG_FT_Int side)
 static PVG_FT_Error
 ft_stroker_cap(PVG_FT_Stroker stroker,
                PVG_FT_Angle angle,
-               PVG_FT_Int side)
+               PVG_FT_Int side,
+               PVG_FT_Stroker_LineCap line_cap)
 {
     PVG_FT_Error error = 0;
 
-    if (stroker->line_cap == PVG_FT_STROKER_LINECAP_ROUND)
+    if (line_cap == PVG_FT_STROKER_LINECAP_ROUND)
     {
         /* add a round cap */
         stroker->angle_in = angle;
@@ -735,7 +737,7 @@ ft_stroker_cap(PVG_FT_Stroker stroker,
         delta.x = side ?  middle.y : -middle.y;
         delta.y = side ? -middle.x :  middle.x;
 
-        if ( stroker->line_cap == PVG_FT_STROKER_LINECAP_SQUARE )
+        if ( line_cap == PVG_FT_STROKER_LINECAP_SQUARE )
         {
             middle.x += stroker->center.x;
             middle.y += stroker->center.y;
@@ -1470,6 +1472,7 @@ PVG_FT_Error PVG_FT_Stroker_BeginSubPath(PVG_FT_Stroker stroker, PVG_FT_Vector*
     stroker->first_point = TRUE;
     stroker->center = *to;
     stroker->subpath_open = open;
+    stroker->subpath_seams = 0;
 
     /* Determine if we need to check whether the border radius is greater */
     /* than the radius of curvature of a curve, to handle this case       */
@@ -1553,11 +1556,19 @@ PVG_FT_Error PVG_FT_Stroker_EndSubPath(PVG_FT_Stroker stroker)
 
     if (stroker->subpath_open) {
         PVG_FT_StrokeBorder right = stroker->borders;
+        PVG_FT_Stroker_LineCap start_cap = stroker->line_cap;
+        PVG_FT_Stroker_LineCap end_cap = stroker->line_cap;
+
+        /* seams are closed by the adjoining stroke, keep them flat */
+        if (stroker->subpath_seams & PVG_FT_STROKER_CONTOUR_SEAM_START)
+            start_cap = PVG_FT_STROKER_LINECAP_BUTT;
+        if (stroker->subpath_seams & PVG_FT_STROKER_CONTOUR_SEAM_END)
+            end_cap = PVG_FT_STROKER_LINECAP_BUTT;
 
         /* All right, this is an opened path, we need to add a cap between */
         /* right & left, add the reverse of left, then add a final cap     */
         /* between left & right.                                           */
-        error = ft_stroker_cap(stroker, stroker->angle_in, 0);
+        error = ft_stroker_cap(stroker, stroker->angle_in, 0, end_cap);
         if (error) goto Exit;
 
         /* add reversed points from `left' to `right' */
@@ -1567,7 +1578,7 @@ PVG_FT_Error PVG_FT_Stroker_EndSubPath(PVG_FT_Stroker stroker)
         /* now add the final cap */
         stroker->center = stroker->subpath_start;
         error =
-            ft_stroker_cap(stroker, stroker->subpath_angle + PVG_FT_ANGLE_PI, 0);
+            ft_stroker_cap(stroker, stroker->subpath_angle + PVG_FT_ANGLE_PI, 0, start_cap);
         if (error) goto Exit;
 
         /* Now end the right subpath accordingly.  The left one is */
@@ -1757,9 +1768,11 @@ PVG_FT_Error PVG_FT_Stroker_ParseOutline(PVG_FT_Stroker        stroker,
             tags--;
         }
 
-        error = PVG_FT_Stroker_BeginSubPath(stroker, &v_start, outline->contours_flag[n]);
+        error = PVG_FT_Stroker_BeginSubPath(stroker, &v_start, outline->contours_flag[n] & PVG_FT_STROKER_CONTOUR_OPEN);
         if (error) goto Exit;
 
+        stroker->subpath_seams = outline->contours_flag[n] & (PVG_FT_STROKER_CONTOUR_SEAM_START | PVG_FT_STROKER_CONTOUR_SEAM_END);
+
         while (point < limit) {
             point++;
             tags++;
@@ -152,6 +152,33 @@ typedef enum  PVG_FT_StrokerBorder_
 } PVG_FT_StrokerBorder;
 
 
+/**************************************************************
+ *
+ * @enum:
+ *   PVG_FT_STROKER_CONTOUR_XXX
+ *
+ * @description:
+ *   Bits of an outline's `contours_flag' entries that are understood
+ *   by @PVG_FT_Stroker_ParseOutline.
+ *
+ * @values:
+ *   PVG_FT_STROKER_CONTOUR_OPEN ::
+ *     The contour is an open path and gets caps at both ends.
+ *
+ *   PVG_FT_STROKER_CONTOUR_SEAM_START ::
+ *     The start of an open contour continues another contour that
+ *     ends at the same point in the same direction.  It always gets
+ *     a butt cap, so that the two strokes meet without overlapping.
+ *
+ *   PVG_FT_STROKER_CONTOUR_SEAM_END ::
+ *     Same as @PVG_FT_STROKER_CONTOUR_SEAM_START, for the end of an
+ *     open contour.
+ */
+#define PVG_FT_STROKER_CONTOUR_OPEN        0x1
+#define PVG_FT_STROKER_CONTOUR_SEAM_START  0x2
+#define PVG_FT_STROKER_CONTOUR_SEAM_END    0x4
+
+
 /**************************************************************
  *
  * @function:
@@ -237,6 +264,9 @@ PVG_FT_Stroker_Set( PVG_FT_Stroker           stroker,
  *   If `opened' is~0 (the default), the outline is treated as a closed
  *   path, and the stroker generates two distinct `border' outlines.
  *
+ *   Each contour's `contours_flag' entry is a combination of the
+ *   @PVG_FT_STROKER_CONTOUR_XXX bits.
+ *
  *
  *   This function calls @PVG_FT_Stroker_Rewind automatically.
  */
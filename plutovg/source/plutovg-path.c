@@ -462,13 +462,19 @@ static inline void split_bezier(const bezier_t* b, bezier_t* first, bezier_t* se
 }
 
 void plutovg_path_traverse_flatten(const plutovg_path_t* path, plutovg_path_traverse_func_t traverse_func, void* closure)
+{
+    plutovg_path_traverse_flatten_tolerance(path, PLUTOVG_PATH_TOLERANCE, traverse_func, closure);
+}
+
+void plutovg_path_traverse_flatten_tolerance(const plutovg_path_t* path, float tolerance, plutovg_path_traverse_func_t traverse_func, void* closure)
 {
     if(path->num_curves == 0) {
         plutovg_path_traverse(path, traverse_func, closure);
         return;
     }
 
-    const float threshold = 0.25f;
+    /* d / l is the sum of the control point distances from the chord, which bounds the deviation by 3/4 of it */
+    const float threshold = tolerance * 4.f / 3.f;
 
     plutovg_path_iterator_t it;
     plutovg_path_iterator_init(&it, path);
@@ -577,6 +583,11 @@ static void dash_traverse_func(void* closure, plutovg_path_command_t command, co
 }
 
 void plutovg_path_traverse_dashed(const plutovg_path_t* path, float offset, const float* dashes, int ndashes, plutovg_path_traverse_func_t traverse_func, void* closure)
+{
+    plutovg_path_traverse_dashed_tolerance(path, offset, dashes, ndashes, PLUTOVG_PATH_TOLERANCE, traverse_func, closure);
+}
+
+void plutovg_path_traverse_dashed_tolerance(const plutovg_path_t* path, float offset, const float* dashes, int ndashes, float tolerance, plutovg_path_traverse_func_t traverse_func, void* closure)
 {
     float dash_sum = 0.f;
     for(int i = 0; i < ndashes; ++i)
@@ -608,7 +619,7 @@ void plutovg_path_traverse_dashed(const plutovg_path_t* path, float offset, cons
     dasher.current_point = PLUTOVG_EMPTY_POINT;
     dasher.traverse_func = traverse_func;
     dasher.closure = closure;
-    plutovg_path_traverse_flatten(path, dash_traverse_func, &dasher);
+    plutovg_path_traverse_flatten_tolerance(path, tolerance, dash_traverse_func, &dasher);
 }
 
 plutovg_path_t* plutovg_path_clone(const plutovg_path_t* path)
@@ -650,10 +661,15 @@ plutovg_path_t* plutovg_path_clone_flatten(const plutovg_path_t* path)
 }
 
 plutovg_path_t* plutovg_path_clone_dashed(const plutovg_path_t* path, float offset, const float* dashes, int ndashes)
+{
+    return plutovg_path_clone_dashed_tolerance(path, offset, dashes, ndashes, PLUTOVG_PATH_TOLERANCE);
+}
+
+plutovg_path_t* plutovg_path_clone_dashed_tolerance(const plutovg_path_t* path, float offset, const float* dashes, int ndashes, float tolerance)
 {
     plutovg_path_t* clone = plutovg_path_create();
     plutovg_path_reserve(clone, path->elements.size + path->num_curves * 32);
-    plutovg_path_traverse_dashed(path, offset, dashes, ndashes, clone_traverse_func, clone);
+    plutovg_path_traverse_dashed_tolerance(path, offset, dashes, ndashes, tolerance, clone_traverse_func, clone);
     return clone;
 }
 
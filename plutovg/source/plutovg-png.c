@@ -0,0 +1,897 @@
+#include "plutovg-private.h"
+#include "plutovg-utils.h"
+
+#define PNG_WINDOW_SIZE 32768
+#define PNG_WINDOW_MASK (PNG_WINDOW_SIZE - 1)
+#define PNG_HASH_BITS 15
+#define PNG_HASH_SIZE (1 << PNG_HASH_BITS)
+#define PNG_MIN_MATCH 3
+#define PNG_MAX_MATCH 258
+#define PNG_TOO_FAR 4096
+#define PNG_MAX_SYMBOLS 16384
+#define PNG_OUTPUT_SIZE 32768
+#define PNG_MAX_STORED 65535
+
+#define PNG_NUM_LITERAL_CODES 286
+#define PNG_NUM_DISTANCE_CODES 30
+#define PNG_NUM_LENGTH_CODES 19
+
+static const uint16_t length_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+
+static const uint8_t length_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+static const uint16_t distance_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+
+static const uint8_t distance_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+static const uint8_t code_length_order[PNG_NUM_LENGTH_CODES] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+typedef struct {
+    int max_chain;
+    int nice_length;
+} png_deflate_config_t;
+
+static const png_deflate_config_t deflate_configs[10] = {
+    {0, 0}, {4, 8}, {8, 16}, {16, 32}, {32, 64},
+    {64, 128}, {128, 128}, {256, 258}, {1024, 258}, {4096, 258}
+};
+
+typedef struct {
+    plutovg_write_func_t write_func;
+    void* closure;
+    int level;
+    int max_chain;
+    int nice_length;
+
+    uint32_t crc_table[256];
+    uint32_t adler;
+
+    uint64_t bit_buffer;
+    int bit_count;
+    uint8_t output[PNG_OUTPUT_SIZE];
+    int output_length;
+
+    uint8_t window[2 * PNG_WINDOW_SIZE];
+    int window_length;
+    int window_pos;
+    int block_start;
+    int32_t head[PNG_HASH_SIZE];
+    int32_t prev[PNG_WINDOW_SIZE];
+
+    uint16_t symbols[PNG_MAX_SYMBOLS];
+    uint16_t distances[PNG_MAX_SYMBOLS];
+    int num_symbols;
+    uint32_t literal_freqs[PNG_NUM_LITERAL_CODES];
+    uint32_t distance_freqs[PNG_NUM_DISTANCE_CODES];
+
+    uint8_t length_codes[256];
+    uint8_t distance_codes[512];
+
+    uint8_t literal_lengths[288];
+    uint16_t literal_codes[288];
+    uint8_t distance_lengths[32];
+    uint16_t distance_codes_bits[32];
+} png_encoder_t;
+
+static void png_init_crc_table(png_encoder_t* encoder)
+{
+    for(uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for(int k = 0; k < 8; k++)
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        encoder->crc_table[n] = c;
+    }
+}
+
+static uint32_t png_update_crc(const png_encoder_t* encoder, uint32_t crc, const uint8_t* data, int length)
+{
+    for(int i = 0; i < length; i++)
+        crc = encoder->crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+static uint32_t png_update_adler(uint32_t adler, const uint8_t* data, int length)
+{
+    uint32_t s1 = adler & 0xFFFF;
+    uint32_t s2 = adler >> 16;
+    while(length > 0) {
+        int n = plutovg_min(length, 5552);
+        for(int i = 0; i < n; i++) {
+            s1 += data[i];
+            s2 += s1;
+        }
+
+        s1 %= 65521;
+        s2 %= 65521;
+        data += n;
+        length -= n;
+    }
+
+    return (s2 << 16) | s1;
+}
+
+static void png_store_u32(uint8_t* data, uint32_t value)
+{
+    data[0] = (value >> 24) & 0xFF;
+    data[1] = (value >> 16) & 0xFF;
+    data[2] = (value >> 8) & 0xFF;
+    data[3] = (value >> 0) & 0xFF;
+}
+
+static void png_write_chunk(png_encoder_t* encoder, const char* type, const uint8_t* data, int length)
+{
+    uint8_t header[8];
+    uint8_t footer[4];
+    png_store_u32(header, length);
+    memcpy(header + 4, type, 4);
+    uint32_t crc = png_update_crc(encoder, 0xFFFFFFFFu, header + 4, 4);
+    crc = png_update_crc(encoder, crc, data, length);
+    png_store_u32(footer, crc ^ 0xFFFFFFFFu);
+    encoder->write_func(encoder->closure, header, 8);
+    if(length > 0)
+        encoder->write_func(encoder->closure, (void*)(data), length);
+    encoder->write_func(encoder->closure, footer, 4);
+}
+
+static void png_flush_output(png_encoder_t* encoder)
+{
+    if(encoder->output_length > 0) {
+        png_write_chunk(encoder, "IDAT", encoder->output, encoder->output_length);
+        encoder->output_length = 0;
+    }
+}
+
+static inline void png_put_byte(png_encoder_t* encoder, uint8_t value)
+{
+    encoder->output[encoder->output_length++] = value;
+    if(encoder->output_length == PNG_OUTPUT_SIZE) {
+        png_flush_output(encoder);
+    }
+}
+
+static void png_put_bytes(png_encoder_t* encoder, const uint8_t* data, int length)
+{
+    while(length > 0) {
+        int n = plutovg_min(length, PNG_OUTPUT_SIZE - encoder->output_length);
+        memcpy(encoder->output + encoder->output_length, data, n);
+        encoder->output_length += n;
+        if(encoder->output_length == PNG_OUTPUT_SIZE)
+            png_flush_output(encoder);
+        data += n;
+        length -= n;
+    }
+}
+
+static inline void png_put_bits(png_encoder_t* encoder, uint32_t value, int count)
+{
+    encoder->bit_buffer |= (uint64_t)(value) << encoder->bit_count;
+    encoder->bit_count += count;
+    while(encoder->bit_count >= 8) {
+        png_put_byte(encoder, encoder->bit_buffer & 0xFF);
+        encoder->bit_buffer >>= 8;
+        encoder->bit_count -= 8;
+    }
+}
+
+static void png_align_bits(png_encoder_t* encoder)
+{
+    if(encoder->bit_count > 0)
+        png_put_bits(encoder, 0, 8 - encoder->bit_count);
+    encoder->bit_buffer = 0;
+    encoder->bit_count = 0;
+}
+
+static void png_calculate_minimum_redundancy(int* A, int n)
+{
+    int root, leaf, next, avbl, used, dpth;
+    A[0] += A[1];
+    root = 0;
+    leaf = 2;
+    for(next = 1; next < n - 1; next++) {
+        if(leaf >= n || A[root] < A[leaf]) {
+            A[next] = A[root];
+            A[root++] = next;
+        } else {
+            A[next] = A[leaf++];
+        }
+
+        if(leaf >= n || (root < next && A[root] < A[leaf])) {
+            A[next] = A[next] + A[root];
+            A[root++] = next;
+        } else {
+            A[next] = A[next] + A[leaf++];
+        }
+    }
+
+    A[n - 2] = 0;
+    for(next = n - 3; next >= 0; next--)
+        A[next] = A[A[next]] + 1;
+    avbl = 1;
+    used = dpth = 0;
+    root = n - 2;
+    next = n - 1;
+    while(avbl > 0) {
+        while(root >= 0 && A[root] == dpth) {
+            used++;
+            root--;
+        }
+
+        while(avbl > used) {
+            A[next--] = dpth;
+            avbl--;
+        }
+
+        avbl = 2 * used;
+        dpth++;
+        used = 0;
+    }
+}
+
+typedef struct {
+    uint32_t freq;
+    int symbol;
+} png_symbol_freq_t;
+
+static int png_symbol_freq_compare(const void* a, const void* b)
+{
+    const png_symbol_freq_t* sa = a;
+    const png_symbol_freq_t* sb = b;
+    if(sa->freq != sb->freq)
+        return sa->freq < sb->freq ? -1 : 1;
+    return sa->symbol - sb->symbol;
+}
+
+static void png_build_code_lengths(const uint32_t* freqs, int count, int max_bits, uint8_t* lengths)
+{
+    png_symbol_freq_t symbols[PNG_NUM_LITERAL_CODES];
+    int depths[PNG_NUM_LITERAL_CODES];
+    int num_codes[33] = {0};
+    int num_symbols = 0;
+    memset(lengths, 0, count);
+    for(int i = 0; i < count; i++) {
+        if(freqs[i] > 0) {
+            symbols[num_symbols].freq = freqs[i];
+            symbols[num_symbols].symbol = i;
+            num_symbols++;
+        }
+    }
+
+    if(num_symbols == 0)
+        return;
+    if(num_symbols == 1) {
+        lengths[symbols[0].symbol] = 1;
+        return;
+    }
+
+    qsort(symbols, num_symbols, sizeof(png_symbol_freq_t), png_symbol_freq_compare);
+    for(int i = 0; i < num_symbols; i++)
+        depths[i] = symbols[i].freq;
+    png_calculate_minimum_redundancy(depths, num_symbols);
+    for(int i = 0; i < num_symbols; i++) {
+        num_codes[plutovg_min(depths[i], 32)]++;
+    }
+
+    for(int i = max_bits + 1; i <= 32; i++)
+        num_codes[max_bits] += num_codes[i];
+    uint32_t total = 0;
+    for(int i = max_bits; i > 0; i--)
+        total += (uint32_t)(num_codes[i]) << (max_bits - i);
+    while(total != (1u << max_bits)) {
+        num_codes[max_bits]--;
+        for(int i = max_bits - 1; i > 0; i--) {
+            if(num_codes[i]) {
+                num_codes[i]--;
+                num_codes[i + 1] += 2;
+                break;
+            }
+        }
+
+        total--;
+    }
+
+    int j = num_symbols;
+    for(int i = 1; i <= max_bits; i++) {
+        for(int k = num_codes[i]; k > 0; k--) {
+            lengths[symbols[--j].symbol] = i;
+        }
+    }
+}
+
+static void png_build_codes(const uint8_t* lengths, int count, uint16_t* codes)
+{
+    int bl_count[16] = {0};
+    int next_code[16];
+    for(int i = 0; i < count; i++)
+        bl_count[lengths[i]]++;
+    bl_count[0] = 0;
+
+    int code = 0;
+    for(int bits = 1; bits < 16; bits++) {
+        code = (code + bl_count[bits - 1]) << 1;
+        next_code[bits] = code;
+    }
+
+    for(int i = 0; i < count; i++) {
+        int length = lengths[i];
+        if(length == 0) {
+            codes[i] = 0;
+            continue;
+        }
+
+        int value = next_code[length]++;
+        int reversed = 0;
+        for(int k = 0; k < length; k++) {
+            reversed = (reversed << 1) | (value & 1);
+            value >>= 1;
+        }
+
+        codes[i] = reversed;
+    }
+}
+
+typedef struct {
+    uint8_t symbols[PNG_NUM_LITERAL_CODES + PNG_NUM_DISTANCE_CODES];
+    uint8_t extras[PNG_NUM_LITERAL_CODES + PNG_NUM_DISTANCE_CODES];
+    int num_symbols;
+    int num_literal_codes;
+    int num_distance_codes;
+    int num_length_codes;
+    uint8_t lengths[PNG_NUM_LENGTH_CODES];
+    uint16_t codes[PNG_NUM_LENGTH_CODES];
+} png_dynamic_header_t;
+
+static void png_push_code_length(png_dynamic_header_t* header, int symbol, int extra)
+{
+    header->symbols[header->num_symbols] = symbol;
+    header->extras[header->num_symbols] = extra;
+    header->num_symbols++;
+}
+
+static int png_build_dynamic_header(png_encoder_t* encoder, png_dynamic_header_t* header)
+{
+    int num_literal_codes = PNG_NUM_LITERAL_CODES;
+    while(num_literal_codes > 257 && encoder->literal_lengths[num_literal_codes - 1] == 0)
+        num_literal_codes--;
+    int num_distance_codes = PNG_NUM_DISTANCE_CODES;
+    while(num_distance_codes > 1 && encoder->distance_lengths[num_distance_codes - 1] == 0) {
+        num_distance_codes--;
+    }
+
+    uint8_t lengths[PNG_NUM_LITERAL_CODES + PNG_NUM_DISTANCE_CODES];
+    memcpy(lengths, encoder->literal_lengths, num_literal_codes);
+    memcpy(lengths + num_literal_codes, encoder->distance_lengths, num_distance_codes);
+
+    header->num_symbols = 0;
+    header->num_literal_codes = num_literal_codes;
+    header->num_distance_codes = num_distance_codes;
+
+    int total = num_literal_codes + num_distance_codes;
+    for(int i = 0; i < total;) {
+        int length = lengths[i];
+        int run = 1;
+        while(i + run < total && lengths[i + run] == length)
+            run++;
+        i += run;
+        if(length == 0) {
+            while(run >= 11) {
+                int n = plutovg_min(run, 138);
+                png_push_code_length(header, 18, n - 11);
+                run -= n;
+            }
+
+            if(run >= 3) {
+                png_push_code_length(header, 17, run - 3);
+                run = 0;
+            }
+        } else {
+            png_push_code_length(header, length, 0);
+            run--;
+            while(run >= 3) {
+                int n = plutovg_min(run, 6);
+                png_push_code_length(header, 16, n - 3);
+                run -= n;
+            }
+        }
+
+        while(run-- > 0) {
+            png_push_code_length(header, length, 0);
+        }
+    }
+
+    uint32_t freqs[PNG_NUM_LENGTH_CODES] = {0};
+    for(int i = 0; i < header->num_symbols; i++)
+        freqs[header->symbols[i]]++;
+    uint32_t code_length_freqs[PNG_NUM_LENGTH_CODES];
+    memcpy(code_length_freqs, freqs, sizeof(freqs));
+    if(header->num_symbols == 1 || (header->num_symbols > 0 && freqs[header->symbols[0]] == (uint32_t)(header->num_symbols))) {
+        // A code-length code must be complete, so give a single used symbol a sibling.
+        code_length_freqs[header->symbols[0] == 0 ? 1 : 0] = 1;
+    }
+
+    png_build_code_lengths(code_length_freqs, PNG_NUM_LENGTH_CODES, 7, header->lengths);
+    png_build_codes(header->lengths, PNG_NUM_LENGTH_CODES, header->codes);
+
+    int num_length_codes = PNG_NUM_LENGTH_CODES;
+    while(num_length_codes > 4 && header->lengths[code_length_order[num_length_codes - 1]] == 0)
+        num_length_codes--;
+    header->num_length_codes = num_length_codes;
+
+    int bits = 5 + 5 + 4 + 3 * num_length_codes;
+    for(int i = 0; i < PNG_NUM_LENGTH_CODES; i++) {
+        int extra = i == 16 ? 2 : i == 17 ? 3 : i == 18 ? 7 : 0;
+        bits += freqs[i] * (header->lengths[i] + extra);
+    }
+
+    return bits;
+}
+
+static void png_write_dynamic_header(png_encoder_t* encoder, const png_dynamic_header_t* header)
+{
+    png_put_bits(encoder, header->num_literal_codes - 257, 5);
+    png_put_bits(encoder, header->num_distance_codes - 1, 5);
+    png_put_bits(encoder, header->num_length_codes - 4, 4);
+    for(int i = 0; i < header->num_length_codes; i++)
+        png_put_bits(encoder, header->lengths[code_length_order[i]], 3);
+    for(int i = 0; i < header->num_symbols; i++) {
+        int symbol = header->symbols[i];
+        png_put_bits(encoder, header->codes[symbol], header->lengths[symbol]);
+        if(symbol == 16) {
+            png_put_bits(encoder, header->extras[i], 2);
+        } else if(symbol == 17) {
+            png_put_bits(encoder, header->extras[i], 3);
+        } else if(symbol == 18) {
+            png_put_bits(encoder, header->extras[i], 7);
+        }
+    }
+}
+
+static inline int png_distance_code(const png_encoder_t* encoder, int distance)
+{
+    distance -= 1;
+    if(distance < 256)
+        return encoder->distance_codes[distance];
+    return encoder->distance_codes[256 + (distance >> 7)];
+}
+
+static int png_block_cost(const png_encoder_t* encoder, const uint8_t* literal_lengths, const uint8_t* distance_lengths)
+{
+    int bits = 0;
+    for(int i = 0; i < PNG_NUM_LITERAL_CODES; i++) {
+        if(encoder->literal_freqs[i] == 0)
+            continue;
+        int extra = i > 256 ? length_extra[i - 257] : 0;
+        bits += encoder->literal_freqs[i] * (literal_lengths[i] + extra);
+    }
+
+    for(int i = 0; i < PNG_NUM_DISTANCE_CODES; i++) {
+        if(encoder->distance_freqs[i] == 0)
+            continue;
+        bits += encoder->distance_freqs[i] * (distance_lengths[i] + distance_extra[i]);
+    }
+
+    return bits;
+}
+
+static void png_init_fixed_lengths(uint8_t* literal_lengths, uint8_t* distance_lengths)
+{
+    for(int i = 0; i < 288; i++)
+        literal_lengths[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+    for(int i = 0; i < 32; i++) {
+        distance_lengths[i] = 5;
+    }
+}
+
+static void png_write_stored_blocks(png_encoder_t* encoder, const uint8_t* data, int length, bool final)
+{
+    do {
+        int n = plutovg_min(length, PNG_MAX_STORED);
+        bool last = final && n == length;
+        png_put_bits(encoder, last ? 1 : 0, 1);
+        png_put_bits(encoder, 0, 2);
+        png_align_bits(encoder);
+        png_put_byte(encoder, n & 0xFF);
+        png_put_byte(encoder, (n >> 8) & 0xFF);
+        png_put_byte(encoder, ~n & 0xFF);
+        png_put_byte(encoder, (~n >> 8) & 0xFF);
+        png_put_bytes(encoder, data, n);
+        data += n;
+        length -= n;
+    } while(length > 0);
+}
+
+static void png_write_symbols(png_encoder_t* encoder)
+{
+    for(int i = 0; i < encoder->num_symbols; i++) {
+        int symbol = encoder->symbols[i];
+        int distance = encoder->distances[i];
+        if(distance == 0) {
+            png_put_bits(encoder, encoder->literal_codes[symbol], encoder->literal_lengths[symbol]);
+            continue;
+        }
+
+        int length_code = encoder->length_codes[symbol - PNG_MIN_MATCH];
+        png_put_bits(encoder, encoder->literal_codes[257 + length_code], encoder->literal_lengths[257 + length_code]);
+        if(length_extra[length_code])
+            png_put_bits(encoder, symbol - length_base[length_code], length_extra[length_code]);
+        int distance_code = png_distance_code(encoder, distance);
+        png_put_bits(encoder, encoder->distance_codes_bits[distance_code], encoder->distance_lengths[distance_code]);
+        if(distance_extra[distance_code]) {
+            png_put_bits(encoder, distance - distance_base[distance_code], distance_extra[distance_code]);
+        }
+    }
+
+    png_put_bits(encoder, encoder->literal_codes[256], encoder->literal_lengths[256]);
+}
+
+static void png_flush_block(png_encoder_t* encoder, bool final)
+{
+    encoder->literal_freqs[256]++;
+
+    uint8_t fixed_literal_lengths[288];
+    uint8_t fixed_distance_lengths[32];
+    png_init_fixed_lengths(fixed_literal_lengths, fixed_distance_lengths);
+    int fixed_cost = 3 + png_block_cost(encoder, fixed_literal_lengths, fixed_distance_lengths);
+
+    uint8_t dynamic_literal_lengths[288] = {0};
+    uint8_t dynamic_distance_lengths[32] = {0};
+    png_build_code_lengths(encoder->literal_freqs, PNG_NUM_LITERAL_CODES, 15, dynamic_literal_lengths);
+    png_build_code_lengths(encoder->distance_freqs, PNG_NUM_DISTANCE_CODES, 15, dynamic_distance_lengths);
+    int num_distance_codes = 0;
+    for(int i = 0; i < PNG_NUM_DISTANCE_CODES; i++)
+        num_distance_codes += dynamic_distance_lengths[i] != 0;
+    if(num_distance_codes == 0) {
+        dynamic_distance_lengths[0] = 1;
+    }
+
+    memcpy(encoder->literal_lengths, dynamic_literal_lengths, sizeof(dynamic_literal_lengths));
+    memcpy(encoder->distance_lengths, dynamic_distance_lengths, sizeof(dynamic_distance_lengths));
+
+    png_dynamic_header_t header;
+    int dynamic_cost = 3 + png_build_dynamic_header(encoder, &header);
+    dynamic_cost += png_block_cost(encoder, dynamic_literal_lengths, dynamic_distance_lengths);
+
+    int block_length = encoder->window_pos - encoder->block_start;
+    if(encoder->block_start >= 0 && block_length <= PNG_MAX_STORED) {
+        int stored_cost = 3 + 7 + 32 + 8 * block_length;
+        if(stored_cost < fixed_cost && stored_cost < dynamic_cost) {
+            png_write_stored_blocks(encoder, encoder->window + encoder->block_start, block_length, final);
+            goto reset;
+        }
+    }
+
+    png_put_bits(encoder, final ? 1 : 0, 1);
+    if(fixed_cost <= dynamic_cost) {
+        memcpy(encoder->literal_lengths, fixed_literal_lengths, sizeof(fixed_literal_lengths));
+        memcpy(encoder->distance_lengths, fixed_distance_lengths, sizeof(fixed_distance_lengths));
+        png_put_bits(encoder, 1, 2);
+    } else {
+        png_put_bits(encoder, 2, 2);
+        png_write_dynamic_header(encoder, &header);
+    }
+
+    png_build_codes(encoder->literal_lengths, 288, encoder->literal_codes);
+    png_build_codes(encoder->distance_lengths, 32, encoder->distance_codes_bits);
+    png_write_symbols(encoder);
+
+reset:
+    encoder->num_symbols = 0;
+    encoder->block_start = encoder->window_pos;
+    memset(encoder->literal_freqs, 0, sizeof(encoder->literal_freqs));
+    memset(encoder->distance_freqs, 0, sizeof(encoder->distance_freqs));
+}
+
+static inline uint32_t png_hash(const uint8_t* data)
+{
+    uint32_t value = data[0] | (data[1] << 8) | (data[2] << 16);
+    return (value * 2654435761u) >> (32 - PNG_HASH_BITS);
+}
+
+static inline void png_insert_hash(png_encoder_t* encoder, int pos)
+{
+    uint32_t hash = png_hash(encoder->window + pos);
+    encoder->prev[pos & PNG_WINDOW_MASK] = encoder->head[hash];
+    encoder->head[hash] = pos;
+}
+
+static inline void png_record_literal(png_encoder_t* encoder, int literal)
+{
+    encoder->symbols[encoder->num_symbols] = literal;
+    encoder->distances[encoder->num_symbols] = 0;
+    encoder->num_symbols++;
+    encoder->literal_freqs[literal]++;
+}
+
+static inline void png_record_match(png_encoder_t* encoder, int length, int distance)
+{
+    encoder->symbols[encoder->num_symbols] = length;
+    encoder->distances[encoder->num_symbols] = distance;
+    encoder->num_symbols++;
+    encoder->literal_freqs[257 + encoder->length_codes[length - PNG_MIN_MATCH]]++;
+    encoder->distance_freqs[png_distance_code(encoder, distance)]++;
+}
+
+static void png_deflate_process(png_encoder_t* encoder, bool flush)
+{
+    const uint8_t* window = encoder->window;
+    int limit = flush ? encoder->window_length : encoder->window_length - PNG_MAX_MATCH;
+    while(encoder->window_pos < limit) {
+        int pos = encoder->window_pos;
+        int available = encoder->window_length - pos;
+        int best_length = 0;
+        int best_distance = 0;
+        if(available >= PNG_MIN_MATCH) {
+            int max_length = plutovg_min(available, PNG_MAX_MATCH);
+            int min_pos = pos - PNG_WINDOW_SIZE;
+            int chain = encoder->max_chain;
+            int candidate = encoder->head[png_hash(window + pos)];
+            const uint8_t* current = window + pos;
+            while(candidate >= 0 && candidate > min_pos && chain-- > 0) {
+                const uint8_t* match = window + candidate;
+                if(match[best_length] == current[best_length] && match[0] == current[0] && match[1] == current[1]) {
+                    int length = 2;
+                    while(length < max_length && match[length] == current[length])
+                        length++;
+                    if(length > best_length) {
+                        best_length = length;
+                        best_distance = pos - candidate;
+                        if(length >= encoder->nice_length || length == max_length) {
+                            break;
+                        }
+                    }
+                }
+
+                candidate = encoder->prev[candidate & PNG_WINDOW_MASK];
+            }
+
+            png_insert_hash(encoder, pos);
+        }
+
+        if(best_length > PNG_MIN_MATCH || (best_length == PNG_MIN_MATCH && best_distance <= PNG_TOO_FAR)) {
+            png_record_match(encoder, best_length, best_distance);
+            if(encoder->level > 1 || best_length <= 4) {
+                int end = plutovg_min(pos + best_length, encoder->window_length - PNG_MIN_MATCH + 1);
+                for(int i = pos + 1; i < end; i++) {
+                    png_insert_hash(encoder, i);
+                }
+            }
+
+            encoder->window_pos += best_length;
+        } else {
+            png_record_literal(encoder, window[pos]);
+            encoder->window_pos += 1;
+        }
+
+        if(encoder->num_symbols == PNG_MAX_SYMBOLS) {
+            png_flush_block(encoder, false);
+        }
+    }
+}
+
+static void png_deflate_slide(png_encoder_t* encoder)
+{
+    memmove(encoder->window, encoder->window + PNG_WINDOW_SIZE, encoder->window_length - PNG_WINDOW_SIZE);
+    encoder->window_length -= PNG_WINDOW_SIZE;
+    encoder->window_pos -= PNG_WINDOW_SIZE;
+    encoder->block_start -= PNG_WINDOW_SIZE;
+    for(int i = 0; i < PNG_HASH_SIZE; i++)
+        encoder->head[i] = encoder->head[i] >= PNG_WINDOW_SIZE ? encoder->head[i] - PNG_WINDOW_SIZE : -1;
+    for(int i = 0; i < PNG_WINDOW_SIZE; i++) {
+        encoder->prev[i] = encoder->prev[i] >= PNG_WINDOW_SIZE ? encoder->prev[i] - PNG_WINDOW_SIZE : -1;
+    }
+}
+
+static void png_deflate_write(png_encoder_t* encoder, const uint8_t* data, int length)
+{
+    encoder->adler = png_update_adler(encoder->adler, data, length);
+    while(length > 0) {
+        if(encoder->window_length == 2 * PNG_WINDOW_SIZE) {
+            if(encoder->level == 0) {
+                png_write_stored_blocks(encoder, encoder->window, encoder->window_length, false);
+                encoder->window_length = 0;
+            } else {
+                png_deflate_process(encoder, false);
+                png_deflate_slide(encoder);
+            }
+        }
+
+        int n = plutovg_min(length, 2 * PNG_WINDOW_SIZE - encoder->window_length);
+        memcpy(encoder->window + encoder->window_length, data, n);
+        encoder->window_length += n;
+        data += n;
+        length -= n;
+    }
+}
+
+static void png_deflate_finish(png_encoder_t* encoder)
+{
+    if(encoder->level == 0) {
+        png_write_stored_blocks(encoder, encoder->window, encoder->window_length, true);
+    } else {
+        png_deflate_process(encoder, true);
+        png_flush_block(encoder, true);
+    }
+
+    png_align_bits(encoder);
+    uint8_t adler[4];
+    png_store_u32(adler, encoder->adler);
+    png_put_bytes(encoder, adler, 4);
+    png_flush_output(encoder);
+}
+
+static void png_encoder_init(png_encoder_t* encoder, plutovg_write_func_t write_func, void* closure, int level)
+{
+    if(level < 0)
+        level = PLUTOVG_PNG_DEFAULT_COMPRESSION_LEVEL;
+    if(level > 9)
+        level = 9;
+    encoder->write_func = write_func;
+    encoder->closure = closure;
+    encoder->level = level;
+    encoder->max_chain = deflate_configs[level].max_chain;
+    encoder->nice_length = deflate_configs[level].nice_length;
+    encoder->adler = 1;
+    encoder->bit_buffer = 0;
+    encoder->bit_count = 0;
+    encoder->output_length = 0;
+    encoder->window_length = 0;
+    encoder->window_pos = 0;
+    encoder->block_start = 0;
+    encoder->num_symbols = 0;
+    memset(encoder->head, 0xFF, sizeof(encoder->head));
+    memset(encoder->prev, 0xFF, sizeof(encoder->prev));
+    memset(encoder->literal_freqs, 0, sizeof(encoder->literal_freqs));
+    memset(encoder->distance_freqs, 0, sizeof(encoder->distance_freqs));
+    png_init_crc_table(encoder);
+
+    for(int code = 0; code < 29; code++) {
+        for(int n = 0; n < (1 << length_extra[code]); n++) {
+            int length = length_base[code] + n;
+            if(length <= PNG_MAX_MATCH) {
+                encoder->length_codes[length - PNG_MIN_MATCH] = code;
+            }
+        }
+    }
+
+    for(int code = 0; code < 30; code++) {
+        for(int n = 0; n < (1 << distance_extra[code]); n++) {
+            int distance = distance_base[code] + n - 1;
+            if(distance < 256) {
+                encoder->distance_codes[distance] = code;
+            } else {
+                encoder->distance_codes[256 + (distance >> 7)] = code;
+            }
+        }
+    }
+}
+
+static inline uint8_t png_paeth_predictor(int a, int b, int c)
+{
+    int p = a + b - c;
+    int pa = abs(p - a);
+    int pb = abs(p - b);
+    int pc = abs(p - c);
+    if(pa <= pb && pa <= pc)
+        return a;
+    if(pb <= pc)
+        return b;
+    return c;
+}
+
+static void png_filter_row(uint8_t* output, const uint8_t* current, const uint8_t* previous, int length, plutovg_png_filter_t filter)
+{
+    *output++ = filter;
+    switch(filter) {
+    case PLUTOVG_PNG_FILTER_SUB:
+        for(int i = 0; i < length; i++)
+            output[i] = current[i] - (i < 4 ? 0 : current[i - 4]);
+        break;
+    case PLUTOVG_PNG_FILTER_UP:
+        for(int i = 0; i < length; i++)
+            output[i] = current[i] - previous[i];
+        break;
+    case PLUTOVG_PNG_FILTER_AVERAGE:
+        for(int i = 0; i < length; i++)
+            output[i] = current[i] - (((i < 4 ? 0 : current[i - 4]) + previous[i]) >> 1);
+        break;
+    case PLUTOVG_PNG_FILTER_PAETH:
+        for(int i = 0; i < length; i++)
+            output[i] = current[i] - (i < 4 ? previous[i] : png_paeth_predictor(current[i - 4], previous[i], previous[i - 4]));
+        break;
+    default:
+        memcpy(output, current, length);
+        break;
+    }
+}
+
+static uint32_t png_filter_cost(const uint8_t* data, int length)
+{
+    uint32_t cost = 0;
+    for(int i = 1; i <= length; i++)
+        cost += abs((int8_t)(data[i]));
+    return cost;
+}
+
+bool plutovg_png_encode(const plutovg_surface_t* surface, plutovg_write_func_t write_func, void* closure, int compression_level, plutovg_png_filter_t filter)
+{
+    if(surface->width <= 0 || surface->height <= 0)
+        return false;
+    if((unsigned int)(filter) > PLUTOVG_PNG_FILTER_ADAPTIVE)
+        filter = PLUTOVG_PNG_FILTER_ADAPTIVE;
+    const int row_length = surface->width * 4;
+    png_encoder_t* encoder = malloc(sizeof(png_encoder_t));
+    uint8_t* rows = malloc(4 * (row_length + 1));
+    if(encoder == NULL || rows == NULL) {
+        free(encoder);
+        free(rows);
+        return false;
+    }
+
+    png_encoder_init(encoder, write_func, closure, compression_level);
+
+    uint8_t* current = rows;
+    uint8_t* previous = current + row_length + 1;
+    uint8_t* filtered = previous + row_length + 1;
+    uint8_t* candidate = filtered + row_length + 1;
+    memset(previous, 0, row_length);
+
+    static const uint8_t signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+    write_func(closure, (void*)(signature), 8);
+
+    uint8_t ihdr[13];
+    png_store_u32(ihdr + 0, surface->width);
+    png_store_u32(ihdr + 4, surface->height);
+    ihdr[8] = 8;
+    ihdr[9] = 6;
+    ihdr[10] = 0;
+    ihdr[11] = 0;
+    ihdr[12] = 0;
+    png_write_chunk(encoder, "IHDR", ihdr, 13);
+
+    const int level = encoder->level;
+    png_put_byte(encoder, 0x78);
+    png_put_byte(encoder, level <= 1 ? 0x01 : level <= 5 ? 0x5E : level == 6 ? 0x9C : 0xDA);
+    for(int y = 0; y < surface->height; y++) {
+        plutovg_convert_argb_to_format(current, row_length, surface->data + surface->stride * y, surface->stride, surface->width, 1, PLUTOVG_PIXEL_FORMAT_RGBA32);
+        if(filter == PLUTOVG_PNG_FILTER_ADAPTIVE) {
+            uint32_t best_cost = UINT32_MAX;
+            for(int type = PLUTOVG_PNG_FILTER_NONE; type <= PLUTOVG_PNG_FILTER_PAETH; type++) {
+                png_filter_row(candidate, current, previous, row_length, type);
+                uint32_t cost = png_filter_cost(candidate, row_length);
+                if(cost < best_cost) {
+                    uint8_t* temp = filtered;
+                    filtered = candidate;
+                    candidate = temp;
+                    best_cost = cost;
+                }
+            }
+        } else {
+            png_filter_row(filtered, current, previous, row_length, filter);
+        }
+
+        png_deflate_write(encoder, filtered, row_length + 1);
+
+        uint8_t* temp = previous;
+        previous = current;
+        current = temp;
+    }
+
+    png_deflate_finish(encoder);
+    png_write_chunk(encoder, "IEND", NULL, 0);
+    free(encoder);
+    free(rows);
+    return true;
+}
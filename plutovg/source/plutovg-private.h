@@ -14,9 +14,22 @@ typedef LONG plutovg_ref_count_t;
 #define plutovg_destroy_reference(ob) (ob && InterlockedDecrement(&(ob)->ref_count) == 0)
 #define plutovg_get_reference_count(ob) ((ob) ? InterlockedCompareExchange((LONG*)&(ob)->ref_count, 0, 0) : 0)
 
+typedef PVOID volatile plutovg_atomic_pointer_t;
+
+#define plutovg_atomic_pointer_init(ptr, value) (*(ptr) = (value))
+#define plutovg_atomic_pointer_load(ptr) InterlockedCompareExchangePointer((ptr), NULL, NULL)
+#define plutovg_atomic_pointer_store(ptr, value) (void)InterlockedExchangePointer((ptr), (value))
+#define plutovg_atomic_pointer_set_if_null(ptr, value) (InterlockedCompareExchangePointer((ptr), (value), NULL) == NULL)
+
+typedef LONG volatile plutovg_atomic_int_t;
+
+#define plutovg_atomic_int_init(ptr, value) (*(ptr) = (value))
+#define plutovg_atomic_int_fetch_add(ptr, value) InterlockedExchangeAdd((ptr), (value))
+
 #elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_ATOMICS__)
 
 #include <stdatomic.h>
+#include <stddef.h>
 
 typedef atomic_int plutovg_ref_count_t;
 
@@ -25,6 +38,23 @@ typedef atomic_int plutovg_ref_count_t;
 #define plutovg_destroy_reference(ob) (ob && atomic_fetch_sub(&(ob)->ref_count, 1) == 1)
 #define plutovg_get_reference_count(ob) ((ob) ? atomic_load(&(ob)->ref_count) : 0)
 
+typedef _Atomic(void*) plutovg_atomic_pointer_t;
+
+#define plutovg_atomic_pointer_init(ptr, value) atomic_init(ptr, value)
+#define plutovg_atomic_pointer_load(ptr) atomic_load_explicit(ptr, memory_order_acquire)
+#define plutovg_atomic_pointer_store(ptr, value) atomic_store_explicit(ptr, value, memory_order_release)
+
+static inline bool plutovg_atomic_pointer_set_if_null(plutovg_atomic_pointer_t* ptr, void* value)
+{
+    void* expected = NULL;
+    return atomic_compare_exchange_strong_explicit(ptr, &expected, value, memory_order_acq_rel, memory_order_acquire);
+}
+
+typedef atomic_int plutovg_atomic_int_t;
+
+#define plutovg_atomic_int_init(ptr, value) atomic_init(ptr, value)
+#define plutovg_atomic_int_fetch_add(ptr, value) atomic_fetch_add(ptr, value)
+
 #else
 
 typedef int plutovg_ref_count_t;
@@ -34,6 +64,18 @@ typedef int plutovg_ref_count_t;
 #define plutovg_destroy_reference(ob) (ob && --(ob)->ref_count == 0)
 #define plutovg_get_reference_count(ob) ((ob) ? (ob)->ref_count : 0)
 
+typedef void* plutovg_atomic_pointer_t;
+
+#define plutovg_atomic_pointer_init(ptr, value) (*(ptr) = (value))
+#define plutovg_atomic_pointer_load(ptr) (*(ptr))
+#define plutovg_atomic_pointer_store(ptr, value) (*(ptr) = (value))
+#define plutovg_atomic_pointer_set_if_null(ptr, value) (*(ptr) == NULL ? (*(ptr) = (value), true) : false)
+
+typedef int plutovg_atomic_int_t;
+
+#define plutovg_atomic_int_init(ptr, value) (*(ptr) = (value))
+#define plutovg_atomic_int_fetch_add(ptr, value) ((*(ptr) += (value)) - (value))
+
 #endif
 
 struct plutovg_surface {
@@ -42,6 +84,7 @@ struct plutovg_surface {
     int height;
     int stride;
     unsigned char* data;
+    plutovg_atomic_pointer_t mipmap;
 };
 
 struct plutovg_path {
@@ -57,6 +100,12 @@ struct plutovg_path {
     } elements;
 };
 
+#define PLUTOVG_PATH_TOLERANCE 0.1875f
+
+void plutovg_path_traverse_flatten_tolerance(const plutovg_path_t* path, float tolerance, plutovg_path_traverse_func_t traverse_func, void* closure);
+void plutovg_path_traverse_dashed_tolerance(const plutovg_path_t* path, float offset, const float* dashes, int ndashes, float tolerance, plutovg_path_traverse_func_t traverse_func, void* closure);
+plutovg_path_t* plutovg_path_clone_dashed_tolerance(const plutovg_path_t* path, float offset, const float* dashes, int ndashes, float tolerance);
+
 typedef enum {
     PLUTOVG_PAINT_TYPE_COLOR,
     PLUTOVG_PAINT_TYPE_GRADIENT,
@@ -110,12 +159,72 @@ typedef struct {
         int capacity;
     } spans;
 
+    struct {
+        int* data;
+        int size;
+        int capacity;
+    } rows;
+
     int x;
     int y;
     int w;
     int h;
 } plutovg_span_buffer_t;
 
+typedef void(*plutovg_span_func_t)(int count, const plutovg_span_t* spans, void* closure);
+
+#define PLUTOVG_COLOR_TABLE_SIZE 1024
+
+typedef struct {
+    plutovg_matrix_t matrix;
+    plutovg_spread_method_t spread;
+    unsigned int colortable[PLUTOVG_COLOR_TABLE_SIZE];
+    union {
+        struct {
+            float x1, y1;
+            float x2, y2;
+        } linear;
+        struct {
+            float cx, cy, cr;
+            float fx, fy, fr;
+        } radial;
+    } values;
+} plutovg_gradient_data_t;
+
+typedef struct {
+    plutovg_matrix_t matrix;
+    unsigned char* data;
+    int width;
+    int height;
+    int stride;
+    int const_alpha;
+} plutovg_texture_data_t;
+
+typedef struct plutovg_blender plutovg_blender_t;
+typedef void(*plutovg_blend_func_t)(const plutovg_blender_t* blender, const plutovg_span_t* spans, int count);
+
+struct plutovg_blender {
+    plutovg_surface_t* surface;
+    plutovg_operator_t op;
+    plutovg_blend_func_t func;
+    union {
+        unsigned int solid;
+        plutovg_gradient_data_t gradient;
+        plutovg_texture_data_t texture;
+    };
+};
+
+#define PLUTOVG_OUTLINE_TAG_ON 1
+#define PLUTOVG_OUTLINE_TAG_CUBIC 2
+
+typedef struct {
+    plutovg_point_t* points;
+    unsigned char* tags;
+    int* contours;
+    int num_points;
+    int num_contours;
+} plutovg_outline_t;
+
 typedef struct {
     float offset;
     struct {
@@ -137,6 +246,23 @@ typedef struct {
     plutovg_stroke_dash_t dash;
 } plutovg_stroke_data_t;
 
+typedef struct {
+    void* buffer;
+    long size;
+} plutovg_raster_pool_t;
+
+/*
+ * A zero flatness means none was set: fills and strokes use the fixed 1/8 px
+ * rasterizer tolerance and dashes the fixed user space tolerance.
+ */
+typedef struct {
+    plutovg_rasterizer_t rasterizer;
+    float flatness;
+    bool glyph_cache;
+} plutovg_raster_config_t;
+
+#define PLUTOVG_DEFAULT_FLATNESS 0.125f
+
 typedef struct plutovg_state {
     plutovg_paint_t* paint;
     plutovg_font_face_t* font_face;
@@ -146,6 +272,7 @@ typedef struct plutovg_state {
     plutovg_span_buffer_t clip_spans;
     plutovg_fill_rule_t winding;
     plutovg_operator_t op;
+    plutovg_texture_filter_t filter;
     float font_size;
     float opacity;
     bool clipping;
@@ -162,6 +289,8 @@ struct plutovg_canvas {
     plutovg_rect_t clip_rect;
     plutovg_span_buffer_t clip_spans;
     plutovg_span_buffer_t fill_spans;
+    plutovg_raster_config_t raster_config;
+    plutovg_raster_pool_t raster_pool;
 };
 
 void plutovg_span_buffer_init(plutovg_span_buffer_t* span_buffer);
@@ -171,10 +300,21 @@ void plutovg_span_buffer_destroy(plutovg_span_buffer_t* span_buffer);
 void plutovg_span_buffer_copy(plutovg_span_buffer_t* span_buffer, const plutovg_span_buffer_t* source);
 bool plutovg_span_buffer_contains(const plutovg_span_buffer_t* span_buffer, float x, float y);
 void plutovg_span_buffer_extents(plutovg_span_buffer_t* span_buffer, plutovg_rect_t* extents);
-void plutovg_span_buffer_intersect(plutovg_span_buffer_t* span_buffer, const plutovg_span_buffer_t* a, const plutovg_span_buffer_t* b);
+void plutovg_span_buffer_intersect(plutovg_span_buffer_t* span_buffer, const plutovg_span_buffer_t* a, plutovg_span_buffer_t* b);
 
-void plutovg_rasterize(plutovg_span_buffer_t* span_buffer, const plutovg_path_t* path, const plutovg_matrix_t* matrix, const plutovg_rect_t* clip_rect, const plutovg_stroke_data_t* stroke_data, plutovg_fill_rule_t winding);
+void plutovg_rasterize(plutovg_span_buffer_t* span_buffer, const plutovg_path_t* path, const plutovg_matrix_t* matrix, const plutovg_rect_t* clip_rect, const plutovg_stroke_data_t* stroke_data, plutovg_fill_rule_t winding, const plutovg_raster_config_t* config, plutovg_raster_pool_t* pool);
+void plutovg_rasterize_spans(plutovg_span_func_t span_func, void* closure, const plutovg_path_t* path, const plutovg_matrix_t* matrix, const plutovg_rect_t* clip_rect, const plutovg_stroke_data_t* stroke_data, plutovg_fill_rule_t winding, const plutovg_raster_config_t* config, plutovg_raster_pool_t* pool);
+void plutovg_rasterize_outlines(plutovg_span_buffer_t* span_buffer, const plutovg_outline_t* const* outlines, const plutovg_matrix_t* matrices, int count, const plutovg_rect_t* clip_rect, plutovg_fill_rule_t winding, const plutovg_raster_config_t* config, plutovg_raster_pool_t* pool);
+bool plutovg_blender_init(plutovg_blender_t* blender, plutovg_canvas_t* canvas);
+void plutovg_blender_blend(const plutovg_blender_t* blender, const plutovg_span_t* spans, int count);
 void plutovg_blend(plutovg_canvas_t* canvas, const plutovg_span_buffer_t* span_buffer);
 void plutovg_memfill32(unsigned int* dest, int length, unsigned int value);
 
+void plutovg_font_face_rasterize_text(plutovg_font_face_t* face, float size, const plutovg_matrix_t* matrix, plutovg_fill_rule_t winding, const plutovg_rect_t* clip_rect,
+    const plutovg_text_run_t* runs, int count, plutovg_text_encoding_t encoding, plutovg_span_buffer_t* span_buffer, const plutovg_raster_config_t* config, plutovg_raster_pool_t* pool, float* advance_width);
+
+plutovg_surface_t* plutovg_surface_get_mipmap(plutovg_surface_t* surface);
+
+bool plutovg_png_encode(const plutovg_surface_t* surface, plutovg_write_func_t write_func, void* closure, int compression_level, plutovg_png_filter_t filter);
+
 #endif // PLUTOVG_PRIVATE_H
@@ -5,16 +5,19 @@
 #include "plutovg-ft-stroker.h"
 
 #include <limits.h>
+#include <string.h>
 
 void plutovg_span_buffer_init(plutovg_span_buffer_t* span_buffer)
 {
     plutovg_array_init(span_buffer->spans);
+    plutovg_array_init(span_buffer->rows);
     plutovg_span_buffer_reset(span_buffer);
 }
 
 void plutovg_span_buffer_init_rect(plutovg_span_buffer_t* span_buffer, int x, int y, int width, int height)
 {
     plutovg_array_clear(span_buffer->spans);
+    plutovg_array_clear(span_buffer->rows);
     plutovg_array_ensure(span_buffer->spans, height);
     plutovg_span_t* spans = span_buffer->spans.data;
     for(int i = 0; i < height; i++) {
@@ -34,6 +37,7 @@ void plutovg_span_buffer_init_rect(plutovg_span_buffer_t* span_buffer, int x, in
 void plutovg_span_buffer_reset(plutovg_span_buffer_t* span_buffer)
 {
     plutovg_array_clear(span_buffer->spans);
+    plutovg_array_clear(span_buffer->rows);
     span_buffer->x = 0;
     span_buffer->y = 0;
     span_buffer->w = -1;
@@ -43,12 +47,15 @@ void plutovg_span_buffer_reset(plutovg_span_buffer_t* span_buffer)
 void plutovg_span_buffer_destroy(plutovg_span_buffer_t* span_buffer)
 {
     plutovg_array_destroy(span_buffer->spans);
+    plutovg_array_destroy(span_buffer->rows);
 }
 
 void plutovg_span_buffer_copy(plutovg_span_buffer_t* span_buffer, const plutovg_span_buffer_t* source)
 {
     plutovg_array_clear(span_buffer->spans);
     plutovg_array_append(span_buffer->spans, source->spans);
+    plutovg_array_clear(span_buffer->rows);
+    plutovg_array_append(span_buffer->rows, source->rows);
     span_buffer->x = source->x;
     span_buffer->y = source->y;
     span_buffer->w = source->w;
@@ -109,58 +116,77 @@ void plutovg_span_buffer_extents(plutovg_span_buffer_t* span_buffer, plutovg_rec
     extents->h = span_buffer->h;
 }
 
-void plutovg_span_buffer_intersect(plutovg_span_buffer_t* span_buffer, const plutovg_span_buffer_t* a, const plutovg_span_buffer_t* b)
+/*
+ * Indexes the spans by row: rows.data[i] is the first span on row y + i, and
+ * the last entry is the span count. The index lives until the spans change,
+ * so a clip mask is indexed once however many fills it is applied to.
+ */
+static void plutovg_span_buffer_update_rows(plutovg_span_buffer_t* span_buffer)
 {
-    plutovg_span_buffer_reset(span_buffer);
-    plutovg_array_ensure(span_buffer->spans, plutovg_max(a->spans.size, b->spans.size));
-
-    plutovg_span_t* a_spans = a->spans.data;
-    plutovg_span_t* a_end = a_spans + a->spans.size;
+    plutovg_span_buffer_update_extents(span_buffer);
+    if(span_buffer->rows.size > 0)
+        return;
+    plutovg_array_ensure(span_buffer->rows, span_buffer->h + 1);
+    const plutovg_span_t* spans = span_buffer->spans.data;
+    int* rows = span_buffer->rows.data;
+    int count = span_buffer->spans.size;
+    int index = 0;
+    for(int i = 0; i < span_buffer->h; i++) {
+        while(index < count && spans[index].y < span_buffer->y + i)
+            ++index;
+        rows[i] = index;
+    }
 
-    plutovg_span_t* b_spans = b->spans.data;
-    plutovg_span_t* b_end = b_spans + b->spans.size;
-    while(a_spans < a_end && b_spans < b_end) {
-        if(b_spans->y > a_spans->y) {
-            ++a_spans;
-            continue;
-        }
+    rows[span_buffer->h] = count;
+    span_buffer->rows.size = span_buffer->h + 1;
+}
 
-        if(a_spans->y != b_spans->y) {
-            ++b_spans;
-            continue;
-        }
+void plutovg_span_buffer_intersect(plutovg_span_buffer_t* span_buffer, const plutovg_span_buffer_t* a, plutovg_span_buffer_t* b)
+{
+    plutovg_span_buffer_reset(span_buffer);
+    if(a->spans.size == 0 || b->spans.size == 0)
+        return;
+    plutovg_span_buffer_update_rows(b);
+    plutovg_array_ensure(span_buffer->spans, a->spans.size);
 
-        int ax1 = a_spans->x;
-        int ax2 = ax1 + a_spans->len;
-        int bx1 = b_spans->x;
-        int bx2 = bx1 + b_spans->len;
-        if(bx1 < ax1 && bx2 < ax1) {
-            ++b_spans;
+    const plutovg_span_t* a_spans = a->spans.data;
+    const plutovg_span_t* a_end = a_spans + a->spans.size;
+    while(a_spans < a_end) {
+        int y = a_spans->y;
+        const plutovg_span_t* a_row_end = a_spans + 1;
+        while(a_row_end < a_end && a_row_end->y == y)
+            ++a_row_end;
+        int row = y - b->y;
+        if(row < 0 || row >= b->h) {
+            a_spans = a_row_end;
             continue;
         }
 
-        if(ax1 < bx1 && ax2 < bx1) {
-            ++a_spans;
-            continue;
-        }
+        const plutovg_span_t* b_spans = b->spans.data + b->rows.data[row];
+        const plutovg_span_t* b_row_end = b->spans.data + b->rows.data[row + 1];
+        while(a_spans < a_row_end && b_spans < b_row_end) {
+            int ax2 = a_spans->x + a_spans->len;
+            int bx2 = b_spans->x + b_spans->len;
+            int x = plutovg_max(a_spans->x, b_spans->x);
+            int len = plutovg_min(ax2, bx2) - x;
+            if(len > 0) {
+                plutovg_array_ensure(span_buffer->spans, 1);
+                plutovg_span_t* span = span_buffer->spans.data + span_buffer->spans.size;
+                span->x = x;
+                span->len = len;
+                span->y = y;
+                span->coverage = (a_spans->coverage * b_spans->coverage) / 255;
+                span_buffer->spans.size += 1;
+            }
 
-        int x = plutovg_max(ax1, bx1);
-        int len = plutovg_min(ax2, bx2) - x;
-        if(len) {
-            plutovg_array_ensure(span_buffer->spans, 1);
-            plutovg_span_t* span = span_buffer->spans.data + span_buffer->spans.size;
-            span->x = x;
-            span->len = len;
-            span->y = a_spans->y;
-            span->coverage = (a_spans->coverage * b_spans->coverage) / 255;
-            span_buffer->spans.size += 1;
+            if(ax2 < bx2) {
+                ++a_spans;
+            } else {
+                ++b_spans;
+            }
         }
 
-        if(ax2 < bx2) {
-            ++a_spans;
-        } else {
-            ++b_spans;
-        }
+        a_spans = a_row_end;
     }
 }
 
@@ -250,35 +276,59 @@ static void ft_outline_end(PVG_FT_Outline* ft)
     }
 }
 
-static PVG_FT_Outline* ft_outline_convert_stroke(const plutovg_path_t* path, const plutovg_matrix_t* matrix, const plutovg_stroke_data_t* stroke_data);
-
-static PVG_FT_Outline* ft_outline_convert(const plutovg_path_t* path, const plutovg_matrix_t* matrix, const plutovg_stroke_data_t* stroke_data)
+/*
+ * Tells whether a device space cubic fits in a box of `flatness' around its
+ * start point, in which case no point of it is further than that from a line.
+ */
+static bool ft_cubic_is_flat(const plutovg_point_t* start, const plutovg_point_t* points, float flatness)
 {
-    if(stroke_data) {
-        return ft_outline_convert_stroke(path, matrix, stroke_data);
+    for(int i = 0; i < 3; i++) {
+        if(fabsf(points[i].x - start->x) > flatness || fabsf(points[i].y - start->y) > flatness) {
+            return false;
+        }
     }
 
+    return true;
+}
+
+/*
+ * Converts a path to device space. When `flatness' is positive, curves whose
+ * control polygon fits within it of their start point become lines, which
+ * spares the stroker from offsetting curves smaller than the tolerance.
+ */
+static PVG_FT_Outline* ft_outline_convert(const plutovg_path_t* path, const plutovg_matrix_t* matrix, float flatness)
+{
     plutovg_path_iterator_t it;
     plutovg_path_iterator_init(&it, path);
 
     plutovg_point_t points[3];
+    plutovg_point_t current_point = {0, 0};
     PVG_FT_Outline* outline = ft_outline_create(path->num_points, path->num_contours);
     while(plutovg_path_iterator_has_next(&it)) {
         switch(plutovg_path_iterator_next(&it, points)) {
         case PLUTOVG_PATH_COMMAND_MOVE_TO:
             plutovg_matrix_map_points(matrix, points, points, 1);
             ft_outline_move_to(outline, points[0].x, points[0].y);
+            current_point = points[0];
             break;
         case PLUTOVG_PATH_COMMAND_LINE_TO:
             plutovg_matrix_map_points(matrix, points, points, 1);
             ft_outline_line_to(outline, points[0].x, points[0].y);
+            current_point = points[0];
             break;
         case PLUTOVG_PATH_COMMAND_CUBIC_TO:
             plutovg_matrix_map_points(matrix, points, points, 3);
-            ft_outline_cubic_to(outline, points[0].x, points[0].y, points[1].x, points[1].y, points[2].x, points[2].y);
+            if(flatness > 0.f && ft_cubic_is_flat(&current_point, points, flatness)) {
+                ft_outline_line_to(outline, points[2].x, points[2].y);
+            } else {
+                ft_outline_cubic_to(outline, points[0].x, points[0].y, points[1].x, points[1].y, points[2].x, points[2].y);
+            }
+
+            current_point = points[2];
             break;
         case PLUTOVG_PATH_COMMAND_CLOSE:
             ft_outline_close(outline);
+            plutovg_matrix_map_points(matrix, points, &current_point, 1);
             break;
         }
     }
@@ -287,58 +337,75 @@ static PVG_FT_Outline* ft_outline_convert(const plutovg_path_t* path, const plut
     return outline;
 }
 
-static PVG_FT_Outline* ft_outline_convert_dash(const plutovg_path_t* path, const plutovg_matrix_t* matrix, const plutovg_stroke_dash_t* stroke_dash)
+static double ft_matrix_scale(const plutovg_matrix_t* matrix)
+{
+    double scale_x = sqrt(matrix->a * matrix->a + matrix->b * matrix->b);
+    double scale_y = sqrt(matrix->c * matrix->c + matrix->d * matrix->d);
+    return hypot(scale_x, scale_y) / PLUTOVG_SQRT2;
+}
+
+static PVG_FT_Outline* ft_outline_convert_dash(const plutovg_path_t* path, const plutovg_matrix_t* matrix, const plutovg_stroke_dash_t* stroke_dash, float flatness)
 {
     if(stroke_dash->array.size == 0)
-        return ft_outline_convert(path, matrix, NULL);
-    plutovg_path_t* dashed = plutovg_path_clone_dashed(path, stroke_dash->offset, stroke_dash->array.data, stroke_dash->array.size);
-    PVG_FT_Outline* outline = ft_outline_convert(dashed, matrix, NULL);
+        return ft_outline_convert(path, matrix, flatness);
+    plutovg_path_t* dashed;
+    if(flatness > 0.f) {
+        /* dashing flattens curves in user space, so scale the device flatness back */
+        float tolerance = (float)(flatness / ft_matrix_scale(matrix));
+        dashed = plutovg_path_clone_dashed_tolerance(path, stroke_dash->offset, stroke_dash->array.data, stroke_dash->array.size, tolerance);
+    } else {
+        dashed = plutovg_path_clone_dashed(path, stroke_dash->offset, stroke_dash->array.data, stroke_dash->array.size);
+    }
+
+    PVG_FT_Outline* outline = ft_outline_convert(dashed, matrix, flatness);
     plutovg_path_destroy(dashed);
     return outline;
 }
 
-static PVG_FT_Outline* ft_outline_convert_stroke(const plutovg_path_t* path, const plutovg_matrix_t* matrix, const plutovg_stroke_data_t* stroke_data)
-{
-    double scale_x = sqrt(matrix->a * matrix->a + matrix->b * matrix->b);
-    double scale_y = sqrt(matrix->c * matrix->c + matrix->d * matrix->d);
+typedef struct {
+    PVG_FT_Fixed width;
+    PVG_FT_Stroker_LineCap cap;
+    PVG_FT_Stroker_LineJoin join;
+    PVG_FT_Fixed miter_limit;
+} ft_stroke_style_t;
 
-    double scale = hypot(scale_x, scale_y) / PLUTOVG_SQRT2;
-    double width = stroke_data->style.width * scale;
+static void ft_stroke_style_init(ft_stroke_style_t* ft_style, const plutovg_matrix_t* matrix, const plutovg_stroke_style_t* style)
+{
+    double width = style->width * ft_matrix_scale(matrix);
 
-    PVG_FT_Fixed ftWidth = (PVG_FT_Fixed)(width * 0.5 * (1 << 6));
-    PVG_FT_Fixed ftMiterLimit = (PVG_FT_Fixed)(stroke_data->style.miter_limit * (1 << 16));
+    ft_style->width = (PVG_FT_Fixed)(width * 0.5 * (1 << 6));
+    ft_style->miter_limit = (PVG_FT_Fixed)(style->miter_limit * (1 << 16));
 
-    PVG_FT_Stroker_LineCap ftCap;
-    switch(stroke_data->style.cap) {
+    switch(style->cap) {
     case PLUTOVG_LINE_CAP_SQUARE:
-        ftCap = PVG_FT_STROKER_LINECAP_SQUARE;
+        ft_style->cap = PVG_FT_STROKER_LINECAP_SQUARE;
         break;
     case PLUTOVG_LINE_CAP_ROUND:
-        ftCap = PVG_FT_STROKER_LINECAP_ROUND;
+        ft_style->cap = PVG_FT_STROKER_LINECAP_ROUND;
         break;
     default:
-        ftCap = PVG_FT_STROKER_LINECAP_BUTT;
+        ft_style->cap = PVG_FT_STROKER_LINECAP_BUTT;
         break;
     }
 
-    PVG_FT_Stroker_LineJoin ftJoin;
-    switch(stroke_data->style.join) {
+    switch(style->join) {
     case PLUTOVG_LINE_JOIN_BEVEL:
-        ftJoin = PVG_FT_STROKER_LINEJOIN_BEVEL;
+        ft_style->join = PVG_FT_STROKER_LINEJOIN_BEVEL;
         break;
     case PLUTOVG_LINE_JOIN_ROUND:
-        ftJoin = PVG_FT_STROKER_LINEJOIN_ROUND;
+        ft_style->join = PVG_FT_STROKER_LINEJOIN_ROUND;
         break;
     default:
-        ftJoin = PVG_FT_STROKER_LINEJOIN_MITER_FIXED;
+        ft_style->join = PVG_FT_STROKER_LINEJOIN_MITER_FIXED;
         break;
     }
+}
 
+static PVG_FT_Outline* ft_outline_stroke(const PVG_FT_Outline* outline, const ft_stroke_style_t* style)
+{
     PVG_FT_Stroker stroker;
     PVG_FT_Stroker_New(&stroker);
-    PVG_FT_Stroker_Set(stroker, ftWidth, ftCap, ftJoin, ftMiterLimit);
-
-    PVG_FT_Outline* outline = ft_outline_convert_dash(path, matrix, &stroke_data->dash);
+    PVG_FT_Stroker_Set(stroker, style->width, style->cap, style->join, style->miter_limit);
     PVG_FT_Stroker_ParseOutline(stroker, outline);
 
     PVG_FT_UInt points;
@@ -349,22 +416,987 @@ static PVG_FT_Outline* ft_outline_convert_stroke(const plutovg_path_t* path, con
     PVG_FT_Stroker_Export(stroker, stroke_outline);
 
     PVG_FT_Stroker_Done(stroker);
+    return stroke_outline;
+}
+
+/*
+ * Long paths are stroked in parallel. Contours are distributed over a few
+ * chunks, and contours too long for a chunk are cut in the middle of a line
+ * segment. Both halves of a cut get a butt cap there, so that their strokes
+ * meet edge to edge. The stroked chunks are merged into a single outline,
+ * which is rasterized once with the non-zero rule.
+ */
+#define STROKE_CHUNK_POINTS 16384
+#define STROKE_MAX_THREADS 8
+#define STROKE_SEAM_SEARCH 256
+
+#if defined(_WIN32)
+
+#include <windows.h>
+
+typedef HANDLE plutovg_thread_t;
+
+#define PLUTOVG_THREAD_FUNC(name, arg) static DWORD WINAPI name(LPVOID arg)
+#define PLUTOVG_THREAD_RETURN return 0
+#define plutovg_thread_create(thread, func, arg) ((*(thread) = CreateThread(NULL, 0, func, arg, 0, NULL)) != NULL)
+#define plutovg_thread_join(thread) (WaitForSingleObject(thread, INFINITE), CloseHandle(thread))
+
+static int plutovg_thread_concurrency(void)
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+}
+
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && defined(HAVE_THREADS_H) && !defined(__STDC_NO_THREADS__)
+
+#include <threads.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+typedef thrd_t plutovg_thread_t;
+
+#define PLUTOVG_THREAD_FUNC(name, arg) static int name(void* arg)
+#define PLUTOVG_THREAD_RETURN return 0
+#define plutovg_thread_create(thread, func, arg) (thrd_create(thread, func, arg) == thrd_success)
+#define plutovg_thread_join(thread) thrd_join(thread, NULL)
+
+static int plutovg_thread_concurrency(void)
+{
+#if defined(_SC_NPROCESSORS_ONLN)
+    return (int)sysconf(_SC_NPROCESSORS_ONLN);
+#else
+    return 1;
+#endif
+}
+
+#else
+
+typedef int plutovg_thread_t;
+
+#define PLUTOVG_THREAD_FUNC(name, arg) static void name(void* arg)
+#define PLUTOVG_THREAD_RETURN return
+#define plutovg_thread_create(thread, func, arg) ((void)(thread), (void)(func), (void)(arg), false)
+#define plutovg_thread_join(thread) ((void)(thread))
+#define plutovg_thread_concurrency() 1
+
+#endif
+
+typedef struct {
+    plutovg_path_t path;
+    const plutovg_matrix_t* matrix;
+    const plutovg_stroke_dash_t* dash;
+    const ft_stroke_style_t* style;
+    float flatness;
+    PVG_FT_Outline* outline;
+    PVG_FT_Outline* result;
+    plutovg_thread_t thread;
+} stroke_task_t;
+
+PLUTOVG_THREAD_FUNC(stroke_task_run, closure)
+{
+    stroke_task_t* task = (stroke_task_t*)(closure);
+    if(task->outline == NULL)
+        task->outline = ft_outline_convert_dash(&task->path, task->matrix, task->dash, task->flatness);
+    task->result = ft_outline_stroke(task->outline, task->style);
+    ft_outline_destroy(task->outline);
+    task->outline = NULL;
+    PLUTOVG_THREAD_RETURN;
+}
+
+typedef struct {
+    int first;
+    int length;
+    int start;
+    int count;
+    int chunk;
+    char flag;
+} ft_outline_piece_t;
+
+typedef struct {
+    ft_outline_piece_t* data;
+    int size;
+    int capacity;
+} ft_outline_piece_array_t;
+
+static inline int ft_piece_index(const ft_outline_piece_t* piece, int offset)
+{
+    return piece->first + (piece->start + offset + piece->length) % piece->length;
+}
+
+static void ft_outline_add_midpoint(PVG_FT_Outline* ft, const PVG_FT_Vector* a, const PVG_FT_Vector* b)
+{
+    ft->points[ft->n_points].x = (a->x + b->x) / 2;
+    ft->points[ft->n_points].y = (a->y + b->y) / 2;
+    ft->tags[ft->n_points] = PVG_FT_CURVE_TAG_ON;
+    ft->n_points++;
+}
+
+static void ft_outline_add_piece(PVG_FT_Outline* ft, const PVG_FT_Outline* source, const ft_outline_piece_t* piece)
+{
+    if(piece->flag & PVG_FT_STROKER_CONTOUR_SEAM_START)
+        ft_outline_add_midpoint(ft, &source->points[ft_piece_index(piece, -1)], &source->points[ft_piece_index(piece, 0)]);
+    for(int i = 0; i < piece->count; i++) {
+        int index = ft_piece_index(piece, i);
+        ft->points[ft->n_points] = source->points[index];
+        ft->tags[ft->n_points] = source->tags[index];
+        ft->n_points++;
+    }
+
+    if(piece->flag & PVG_FT_STROKER_CONTOUR_SEAM_END)
+        ft_outline_add_midpoint(ft, &source->points[ft_piece_index(piece, piece->count - 1)], &source->points[ft_piece_index(piece, piece->count)]);
+    ft->contours[ft->n_contours] = ft->n_points - 1;
+    ft->contours_flag[ft->n_contours] = piece->flag;
+    ft->n_contours++;
+}
+
+/*
+ * Finds a line segment at or after `offset' whose midpoint can take a seam.
+ * Segments with even deltas are preferred, as both halves then have exactly
+ * the same direction and the two butt caps coincide.
+ */
+static int ft_outline_find_seam(const PVG_FT_Outline* source, const ft_outline_piece_t* contour, int offset, int limit)
+{
+    int fallback = -1;
+    limit = plutovg_min(limit, offset + STROKE_SEAM_SEARCH);
+    for(int i = offset; i < limit; i++) {
+        int a = ft_piece_index(contour, i);
+        int b = ft_piece_index(contour, i + 1);
+        if(PVG_FT_CURVE_TAG(source->tags[a]) != PVG_FT_CURVE_TAG_ON || PVG_FT_CURVE_TAG(source->tags[b]) != PVG_FT_CURVE_TAG_ON)
+            continue;
+        PVG_FT_Pos dx = source->points[b].x - source->points[a].x;
+        PVG_FT_Pos dy = source->points[b].y - source->points[a].y;
+        PVG_FT_Pos length = plutovg_max(labs(dx), labs(dy));
+        if(length >= 2 && (dx & 1) == 0 && (dy & 1) == 0)
+            return i;
+        if(fallback == -1 && length >= 64) {
+            fallback = i;
+        }
+    }
+
+    return fallback;
+}
+
+static int ft_outline_split(const PVG_FT_Outline* source, PVG_FT_Outline** chunks, int count)
+{
+    ft_outline_piece_array_t pieces;
+    plutovg_array_init(pieces);
+
+    int target = (source->n_points + count - 1) / count;
+    int chunk = 0;
+    int size = 0;
+    int first = 0;
+    for(int n = 0; n < source->n_contours; first = source->contours[n++] + 1) {
+        int last = source->contours[n];
+        ft_outline_piece_t contour = {first, last - first + 1, 0, last - first + 1, chunk, source->contours_flag[n]};
+        if(last < first)
+            continue;
+        if(chunk == count - 1 || size + contour.count <= target) {
+            plutovg_array_ensure(pieces, 1);
+            pieces.data[pieces.size++] = contour;
+            size += contour.count;
+            if(size >= target && chunk < count - 1) {
+                chunk++;
+                size = 0;
+            }
+
+            continue;
+        }
+
+        bool closed = !(contour.flag & PVG_FT_STROKER_CONTOUR_OPEN);
+        if(closed) {
+            ft_outline_piece_t cycle = contour;
+            const PVG_FT_Vector* a = &source->points[first];
+            const PVG_FT_Vector* b = &source->points[last];
+            if(cycle.length > 1 && a->x == b->x && a->y == b->y)
+                cycle.length--;
+            int seam = ft_outline_find_seam(source, &cycle, 0, cycle.length);
+            if(seam == -1) {
+                plutovg_array_ensure(pieces, 1);
+                pieces.data[pieces.size++] = contour;
+                size += contour.count;
+                continue;
+            }
+
+            contour.length = cycle.length;
+            contour.start = seam + 1;
+            contour.count = cycle.length;
+            contour.flag = PVG_FT_STROKER_CONTOUR_OPEN;
+        }
+
+        int offset = 0;
+        bool seam_start = closed;
+        while(true) {
+            ft_outline_piece_t piece = contour;
+            piece.start = contour.start + offset;
+            piece.chunk = chunk;
+            if(seam_start)
+                piece.flag |= PVG_FT_STROKER_CONTOUR_SEAM_START;
+            if(closed) {
+                piece.flag |= PVG_FT_STROKER_CONTOUR_SEAM_END;
+            }
+
+            int room = chunk == count - 1 ? contour.count : plutovg_max(target - size, 2);
+            int seam = -1;
+            if(offset + room < contour.count)
+                seam = ft_outline_find_seam(source, &contour, offset + room - 1, contour.count - 1);
+            if(seam == -1) {
+                piece.count = contour.count - offset;
+                plutovg_array_ensure(pieces, 1);
+                pieces.data[pieces.size++] = piece;
+                size += piece.count;
+                break;
+            }
+
+            piece.count = seam - offset + 1;
+            piece.flag |= PVG_FT_STROKER_CONTOUR_SEAM_END;
+            plutovg_array_ensure(pieces, 1);
+            pieces.data[pieces.size++] = piece;
+            offset = seam + 1;
+            seam_start = true;
+            chunk++;
+            size = 0;
+        }
+    }
+
+    int num_chunks = pieces.size ? pieces.data[pieces.size - 1].chunk + 1 : 0;
+    for(int i = 0, j = 0; i < num_chunks; i++) {
+        int points = 0;
+        int contours = 0;
+        for(int k = j; k < pieces.size && pieces.data[k].chunk == i; k++) {
+            points += pieces.data[k].count + 2;
+            contours += 1;
+        }
+
+        chunks[i] = ft_outline_create(points, contours);
+        for(; j < pieces.size && pieces.data[j].chunk == i; j++) {
+            ft_outline_add_piece(chunks[i], source, &pieces.data[j]);
+        }
+    }
+
+    plutovg_array_destroy(pieces);
+    return num_chunks;
+}
+
+static int ft_path_split(const plutovg_path_t* path, stroke_task_t* tasks, int count)
+{
+    const plutovg_path_element_t* elements = path->elements.data;
+    int target = (path->num_points + count - 1) / count;
+    int num_tasks = 0;
+    int start = 0;
+    int points = 0;
+    int contours = 0;
+    int curves = 0;
+    for(int i = 0; i <= path->elements.size; i += elements[i].header.length) {
+        if(i == path->elements.size || (elements[i].header.command == PLUTOVG_PATH_COMMAND_MOVE_TO && points >= target && num_tasks < count - 1)) {
+            if(points > 0) {
+                plutovg_path_t* view = &tasks[num_tasks++].path;
+                view->ref_count = 1;
+                view->num_points = points;
+                view->num_contours = contours;
+                view->num_curves = curves;
+                view->start_point = elements[start + 1].point;
+                view->elements.data = (plutovg_path_element_t*)(elements + start);
+                view->elements.size = i - start;
+                view->elements.capacity = i - start;
+            }
+
+            if(i == path->elements.size)
+                break;
+            start = i;
+            points = 0;
+            contours = 0;
+            curves = 0;
+        }
+
+        points += elements[i].header.length - 1;
+        if(elements[i].header.command == PLUTOVG_PATH_COMMAND_MOVE_TO)
+            contours += 1;
+        if(elements[i].header.command == PLUTOVG_PATH_COMMAND_CUBIC_TO) {
+            curves += 1;
+        }
+    }
+
+    return num_tasks;
+}
+
+static PVG_FT_Outline* ft_outline_merge(stroke_task_t* tasks, int count)
+{
+    int points = 0;
+    int contours = 0;
+    for(int i = 0; i < count; i++) {
+        points += tasks[i].result->n_points;
+        contours += tasks[i].result->n_contours;
+    }
+
+    PVG_FT_Outline* outline = ft_outline_create(points, contours);
+    for(int i = 0; i < count; i++) {
+        const PVG_FT_Outline* result = tasks[i].result;
+        memcpy(outline->points + outline->n_points, result->points, result->n_points * sizeof(PVG_FT_Vector));
+        memcpy(outline->tags + outline->n_points, result->tags, result->n_points * sizeof(char));
+        memcpy(outline->contours_flag + outline->n_contours, result->contours_flag, result->n_contours * sizeof(char));
+        for(int j = 0; j < result->n_contours; j++)
+            outline->contours[outline->n_contours + j] = result->contours[j] + outline->n_points;
+        outline->n_points += result->n_points;
+        outline->n_contours += result->n_contours;
+        ft_outline_destroy(tasks[i].result);
+    }
+
+    return outline;
+}
+
+static PVG_FT_Outline* ft_outline_stroke_parallel(const plutovg_path_t* path, const plutovg_matrix_t* matrix, const plutovg_stroke_dash_t* stroke_dash, const ft_stroke_style_t* style, float flatness, int count)
+{
+    stroke_task_t tasks[STROKE_MAX_THREADS];
+    int num_tasks = 0;
+    if(stroke_dash->array.size > 0)
+        num_tasks = ft_path_split(path, tasks, count);
+    if(num_tasks < 2) {
+        PVG_FT_Outline* chunks[STROKE_MAX_THREADS];
+        PVG_FT_Outline* outline = ft_outline_convert_dash(path, matrix, stroke_dash, flatness);
+        num_tasks = ft_outline_split(outline, chunks, count);
+        ft_outline_destroy(outline);
+        for(int i = 0; i < num_tasks; i++) {
+            tasks[i].outline = chunks[i];
+        }
+    } else {
+        for(int i = 0; i < num_tasks; i++) {
+            tasks[i].outline = NULL;
+        }
+    }
+
+    bool started[STROKE_MAX_THREADS] = {false};
+    for(int i = 0; i < num_tasks; i++) {
+        tasks[i].matrix = matrix;
+        tasks[i].dash = stroke_dash;
+        tasks[i].style = style;
+        tasks[i].flatness = flatness;
+        if(i > 0) {
+            started[i] = plutovg_thread_create(&tasks[i].thread, stroke_task_run, &tasks[i]);
+        }
+    }
+
+    for(int i = 0; i < num_tasks; i++) {
+        if(started[i]) {
+            plutovg_thread_join(tasks[i].thread);
+        } else {
+            stroke_task_run(&tasks[i]);
+        }
+    }
+
+    return ft_outline_merge(tasks, num_tasks);
+}
+
+static PVG_FT_Outline* ft_outline_convert_stroke(const plutovg_path_t* path, const plutovg_matrix_t* matrix, const plutovg_stroke_data_t* stroke_data, float flatness)
+{
+    ft_stroke_style_t style;
+    ft_stroke_style_init(&style, matrix, &stroke_data->style);
+
+    int count = plutovg_min(path->num_points / STROKE_CHUNK_POINTS, STROKE_MAX_THREADS);
+    if(count > 1)
+        count = plutovg_min(count, plutovg_thread_concurrency());
+    if(count > 1) {
+        return ft_outline_stroke_parallel(path, matrix, &stroke_data->dash, &style, flatness, count);
+    }
+
+    PVG_FT_Outline* outline = ft_outline_convert_dash(path, matrix, &stroke_data->dash, flatness);
+    PVG_FT_Outline* stroke_outline = ft_outline_stroke(outline, &style);
     ft_outline_destroy(outline);
     return stroke_outline;
 }
 
-static void spans_generation_callback(int count, const PVG_FT_Span* spans, void* user)
+static void spans_generation_callback(int count, const plutovg_span_t* spans, void* closure)
 {
-    plutovg_span_buffer_t* span_buffer = (plutovg_span_buffer_t*)(user);
+    plutovg_span_buffer_t* span_buffer = (plutovg_span_buffer_t*)(closure);
     plutovg_array_append_data(span_buffer->spans, spans, count);
 }
 
-void plutovg_rasterize(plutovg_span_buffer_t* span_buffer, const plutovg_path_t* path, const plutovg_matrix_t* matrix, const plutovg_rect_t* clip_rect, const plutovg_stroke_data_t* stroke_data, plutovg_fill_rule_t winding)
+/*
+ * Analytic area rasterizer. Every edge is accumulated into a dense grid of
+ * per-pixel cover/area cells spanning the outline's bounding box, and the
+ * grid is then swept row by row. There is no cell search or sorting, which
+ * makes it cheap for the small shapes that dominate charts and diagrams, but
+ * the grid grows with the box area, so larger outlines are left to the cell
+ * rasterizer.
+ */
+#define ANALYTIC_MAX_AREA (64 * 64)
+
+typedef struct {
+    float cover;
+    float area;
+} analytic_cell_t;
+
+typedef struct {
+    int min;
+    int max;
+} analytic_extent_t;
+
+typedef struct {
+    analytic_cell_t* cells;
+    analytic_extent_t* extents;
+    int width;
+    int height;
+    float x;
+    float y;
+    float flatness;
+    float last_x;
+    float last_y;
+} analytic_raster_t;
+
+static inline void analytic_cell(analytic_raster_t* ras, analytic_cell_t* row, int column, float fx1, float fx2, float dy)
+{
+    if(column >= ras->width)
+        return;
+    analytic_cell_t* cell = row + column;
+    cell->cover += dy;
+    cell->area += dy * (fx1 + fx2) * 0.5f;
+}
+
+static inline void analytic_touch(analytic_raster_t* ras, int y, int min, int max)
+{
+    analytic_extent_t* extent = ras->extents + y;
+    extent->min = plutovg_min(extent->min, min);
+    extent->max = plutovg_max(extent->max, plutovg_min(max, ras->width - 1));
+}
+
+static void analytic_row(analytic_raster_t* ras, int y, float x1, float x2, float dy)
 {
-    PVG_FT_Outline* outline = ft_outline_convert(path, matrix, stroke_data);
+    analytic_cell_t* row = ras->cells + y * (ras->width + 1);
+    if(x1 > x2) {
+        float t = x1;
+        x1 = x2;
+        x2 = t;
+    }
+
+    if(x1 >= ras->width)
+        return;
+    if(x2 <= 0.f) {
+        row[0].cover += dy;
+        analytic_touch(ras, y, 0, 0);
+        return;
+    }
+
+    float scale = x2 > x1 ? dy / (x2 - x1) : 0.f;
+    if(x1 < 0.f) {
+        analytic_touch(ras, y, 0, 0);
+        row[0].cover += scale * -x1;
+        dy -= scale * -x1;
+        x1 = 0.f;
+    }
+
+    if(x2 > ras->width) {
+        dy -= scale * (x2 - ras->width);
+        x2 = (float)ras->width;
+    }
+
+    int c1 = (int)x1;
+    int c2 = (int)x2;
+    analytic_touch(ras, y, c1, c2);
+    if(c1 == c2 || (x2 == c2 && c1 == c2 - 1)) {
+        analytic_cell(ras, row, c1, x1 - c1, x2 - c1, dy);
+        return;
+    }
+
+    analytic_cell(ras, row, c1, x1 - c1, 1.f, scale * (c1 + 1 - x1));
+    for(int c = c1 + 1; c < c2; c++)
+        analytic_cell(ras, row, c, 0.f, 1.f, scale);
+    if(x2 > c2) {
+        analytic_cell(ras, row, c2, 0.f, x2 - c2, scale * (x2 - c2));
+    }
+}
+
+static void analytic_line_to(analytic_raster_t* ras, float x, float y)
+{
+    float x1 = ras->last_x;
+    float y1 = ras->last_y;
+    float x2 = ras->last_x = x;
+    float y2 = ras->last_y = y;
+    if(y1 == y2)
+        return;
+    float dir = 1.f;
+    if(y1 > y2) {
+        float t = x1; x1 = x2; x2 = t;
+        t = y1; y1 = y2; y2 = t;
+        dir = -1.f;
+    }
+
+    float height = (float)ras->height;
+    if(y2 <= 0.f || y1 >= height)
+        return;
+    float dxdy = (x2 - x1) / (y2 - y1);
+    if(y1 < 0.f) {
+        x1 -= dxdy * y1;
+        y1 = 0.f;
+    }
+
+    if(y2 > height) {
+        x2 -= dxdy * (y2 - height);
+        y2 = height;
+    }
+
+    float cx = x1;
+    float cy = y1;
+    while(cy < y2) {
+        int row = (int)cy;
+        float ny = plutovg_min(row + 1.f, y2);
+        float nx = ny == y2 ? x2 : x1 + dxdy * (ny - y1);
+        analytic_row(ras, row, cx, nx, dir * (ny - cy));
+        cx = nx;
+        cy = ny;
+    }
+}
+
+static void analytic_conic_to(analytic_raster_t* ras, float x1, float y1, float x2, float y2)
+{
+    float x0 = ras->last_x;
+    float y0 = ras->last_y;
+    float ddx = x0 - 2.f * x1 + x2;
+    float ddy = y0 - 2.f * y1 + y2;
+    float dd = sqrtf(ddx * ddx + ddy * ddy);
+    int n = (int)ceilf(sqrtf(dd / (8.f * ras->flatness)));
+    n = plutovg_max(1, plutovg_min(n, 64));
+    for(int i = 1; i < n; i++) {
+        float t = (float)i / n;
+        float mt = 1.f - t;
+        analytic_line_to(ras, mt * mt * x0 + 2.f * mt * t * x1 + t * t * x2, mt * mt * y0 + 2.f * mt * t * y1 + t * t * y2);
+    }
+
+    analytic_line_to(ras, x2, y2);
+}
+
+static void analytic_cubic_to(analytic_raster_t* ras, float x1, float y1, float x2, float y2, float x3, float y3)
+{
+    float x0 = ras->last_x;
+    float y0 = ras->last_y;
+    float ddx1 = x0 - 2.f * x1 + x2;
+    float ddy1 = y0 - 2.f * y1 + y2;
+    float ddx2 = x1 - 2.f * x2 + x3;
+    float ddy2 = y1 - 2.f * y2 + y3;
+    float dd = sqrtf(plutovg_max(ddx1 * ddx1 + ddy1 * ddy1, ddx2 * ddx2 + ddy2 * ddy2));
+    int n = (int)ceilf(sqrtf(3.f * dd / (4.f * ras->flatness)));
+    n = plutovg_max(1, plutovg_min(n, 64));
+    for(int i = 1; i < n; i++) {
+        float t = (float)i / n;
+        float mt = 1.f - t;
+        float a = mt * mt * mt;
+        float b = 3.f * mt * mt * t;
+        float c = 3.f * mt * t * t;
+        float d = t * t * t;
+        analytic_line_to(ras, a * x0 + b * x1 + c * x2 + d * x3, a * y0 + b * y1 + c * y2 + d * y3);
+    }
+
+    analytic_line_to(ras, x3, y3);
+}
+
+#define ANALYTIC_X(ras, v) ((v).x / 64.f - (ras)->x)
+#define ANALYTIC_Y(ras, v) ((v).y / 64.f - (ras)->y)
+
+static void analytic_decompose(analytic_raster_t* ras, const PVG_FT_Outline* outline)
+{
+    int first = 0;
+    for(int n = 0; n < outline->n_contours; n++) {
+        int last = outline->contours[n];
+        const PVG_FT_Vector* points = outline->points;
+        const char* tags = outline->tags;
+
+        /* find an on-curve starting point, synthesizing one between two conic controls */
+        float start_x, start_y;
+        int index = first;
+        int end = last;
+        if(PVG_FT_CURVE_TAG(tags[first]) == PVG_FT_CURVE_TAG_ON) {
+            start_x = ANALYTIC_X(ras, points[first]);
+            start_y = ANALYTIC_Y(ras, points[first]);
+            index = first + 1;
+        } else if(PVG_FT_CURVE_TAG(tags[last]) == PVG_FT_CURVE_TAG_ON) {
+            start_x = ANALYTIC_X(ras, points[last]);
+            start_y = ANALYTIC_Y(ras, points[last]);
+            end = last - 1;
+        } else {
+            start_x = (ANALYTIC_X(ras, points[first]) + ANALYTIC_X(ras, points[last])) * 0.5f;
+            start_y = (ANALYTIC_Y(ras, points[first]) + ANALYTIC_Y(ras, points[last])) * 0.5f;
+        }
+
+        ras->last_x = start_x;
+        ras->last_y = start_y;
+        while(index <= end) {
+            int tag = PVG_FT_CURVE_TAG(tags[index]);
+            float x = ANALYTIC_X(ras, points[index]);
+            float y = ANALYTIC_Y(ras, points[index]);
+            if(tag == PVG_FT_CURVE_TAG_ON) {
+                analytic_line_to(ras, x, y);
+                index += 1;
+            } else if(tag == PVG_FT_CURVE_TAG_CONIC) {
+                float cx = x;
+                float cy = y;
+                for(index += 1; index <= end; index += 1) {
+                    float nx = ANALYTIC_X(ras, points[index]);
+                    float ny = ANALYTIC_Y(ras, points[index]);
+                    if(PVG_FT_CURVE_TAG(tags[index]) == PVG_FT_CURVE_TAG_ON) {
+                        analytic_conic_to(ras, cx, cy, nx, ny);
+                        break;
+                    }
+
+                    analytic_conic_to(ras, cx, cy, (cx + nx) * 0.5f, (cy + ny) * 0.5f);
+                    cx = nx;
+                    cy = ny;
+                }
+
+                if(index > end) {
+                    analytic_conic_to(ras, cx, cy, start_x, start_y);
+                } else {
+                    index += 1;
+                }
+            } else {
+                if(index + 1 > end)
+                    break;
+                float x2 = ANALYTIC_X(ras, points[index + 1]);
+                float y2 = ANALYTIC_Y(ras, points[index + 1]);
+                if(index + 2 <= end) {
+                    analytic_cubic_to(ras, x, y, x2, y2, ANALYTIC_X(ras, points[index + 2]), ANALYTIC_Y(ras, points[index + 2]));
+                } else {
+                    analytic_cubic_to(ras, x, y, x2, y2, start_x, start_y);
+                }
+
+                index += 3;
+            }
+        }
+
+        analytic_line_to(ras, start_x, start_y);
+        first = last + 1;
+    }
+}
+
+static inline int analytic_coverage(float value, bool even_odd)
+{
+    int coverage = (int)(fabsf(value) * 256.f + 0.5f);
+    if(even_odd) {
+        coverage &= 511;
+        if(coverage > 256) {
+            coverage = 512 - coverage;
+        }
+    }
+
+    return plutovg_min(coverage, 255);
+}
+
+static void analytic_sweep(analytic_raster_t* ras, bool even_odd, int x_offset, int y_offset, plutovg_span_func_t span_func, void* closure)
+{
+    plutovg_span_t spans[256];
+    int count = 0;
+    for(int y = 0; y < ras->height; y++) {
+        const analytic_extent_t* extent = ras->extents + y;
+        if(extent->min > extent->max)
+            continue;
+        const analytic_cell_t* row = ras->cells + y * (ras->width + 1);
+        float cover = 0.f;
+        int cover_coverage = 0;
+        int start = extent->min;
+        int current = 0;
+        for(int x = extent->min; x <= ras->width; x++) {
+            int coverage = 0;
+            bool settled = x > extent->max && x < ras->width;
+            if(settled) {
+                /* past the last touched cell the coverage no longer changes */
+                coverage = cover_coverage;
+            } else if(x < ras->width) {
+                const analytic_cell_t* cell = row + x;
+                if(cell->cover == 0.f && cell->area == 0.f) {
+                    coverage = cover_coverage;
+                } else {
+                    coverage = analytic_coverage(cover + cell->cover - cell->area, even_odd);
+                    if(cell->cover != 0.f) {
+                        cover += cell->cover;
+                        cover_coverage = analytic_coverage(cover, even_odd);
+                    }
+                }
+            }
+
+            if(coverage != current) {
+                if(current > 0) {
+                    plutovg_span_t* span = &spans[count++];
+                    span->x = x_offset + start;
+                    span->len = x - start;
+                    span->y = y_offset + y;
+                    span->coverage = current;
+                    if(count == 256) {
+                        span_func(count, spans, closure);
+                        count = 0;
+                    }
+                }
+
+                start = x;
+                current = coverage;
+            }
+
+            if(settled) {
+                x = ras->width - 1;
+            }
+        }
+    }
+
+    if(count > 0) {
+        span_func(count, spans, closure);
+    }
+}
+
+static bool analytic_outline_render(plutovg_span_func_t span_func, void* closure, const PVG_FT_Outline* outline, const plutovg_rect_t* clip_rect, const plutovg_raster_config_t* config, plutovg_raster_pool_t* pool)
+{
+    if(outline->n_points == 0 || outline->n_contours <= 0)
+        return true;
+    PVG_FT_BBox cbox;
+    PVG_FT_Outline_Get_CBox(outline, &cbox);
+
+    int x1 = (int)(cbox.xMin >> 6);
+    int y1 = (int)(cbox.yMin >> 6);
+    int x2 = (int)((cbox.xMax + 63) >> 6);
+    int y2 = (int)((cbox.yMax + 63) >> 6);
+    if(clip_rect) {
+        x1 = plutovg_max(x1, (int)clip_rect->x);
+        y1 = plutovg_max(y1, (int)clip_rect->y);
+        x2 = plutovg_min(x2, (int)(clip_rect->x + clip_rect->w));
+        y2 = plutovg_min(y2, (int)(clip_rect->y + clip_rect->h));
+    }
+
+    if(x2 <= x1 || y2 <= y1)
+        return true;
+    if((long)(x2 - x1) * (y2 - y1) > ANALYTIC_MAX_AREA) {
+        return false;
+    }
+
+    analytic_raster_t ras;
+    ras.width = x2 - x1;
+    ras.height = y2 - y1;
+    ras.x = (float)x1;
+    ras.y = (float)y1;
+    ras.flatness = config->flatness > 0.f ? config->flatness : PLUTOVG_DEFAULT_FLATNESS;
+
+    long cells_size = (long)sizeof(analytic_cell_t) * (ras.width + 1) * ras.height;
+    long size = cells_size + (long)sizeof(analytic_extent_t) * ras.height;
+    if(pool->size < size) {
+        free(pool->buffer);
+        pool->buffer = malloc(size);
+        pool->size = pool->buffer ? size : 0;
+        if(pool->buffer == NULL) {
+            return false;
+        }
+    }
+
+    ras.cells = pool->buffer;
+    ras.extents = (analytic_extent_t*)((char*)pool->buffer + cells_size);
+    memset(ras.cells, 0, cells_size);
+    for(int i = 0; i < ras.height; i++) {
+        ras.extents[i].min = ras.width;
+        ras.extents[i].max = -1;
+    }
+    analytic_decompose(&ras, outline);
+    analytic_sweep(&ras, outline->flags & PVG_FT_OUTLINE_EVEN_ODD_FILL, x1, y1, span_func, closure);
+    return true;
+}
+
+typedef struct {
+    plutovg_span_func_t func;
+    void* closure;
+} span_stream_t;
+
+static void spans_stream_callback(int count, const PVG_FT_Span* spans, void* user)
+{
+    span_stream_t* stream = (span_stream_t*)(user);
+    stream->func(count, (const plutovg_span_t*)(spans), stream->closure);
+}
+
+static void ft_outline_render(plutovg_span_func_t span_func, void* closure, PVG_FT_Outline* outline, const plutovg_rect_t* clip_rect, const plutovg_raster_config_t* config, plutovg_raster_pool_t* pool)
+{
+    if(config && pool && config->rasterizer == PLUTOVG_RASTERIZER_ANALYTIC && analytic_outline_render(span_func, closure, outline, clip_rect, config, pool)) {
+        return;
+    }
+
+    span_stream_t stream = {span_func, closure};
+    PVG_FT_Raster_Params params;
+    params.flags = PVG_FT_RASTER_FLAG_DIRECT | PVG_FT_RASTER_FLAG_AA;
+    params.gray_spans = spans_stream_callback;
+    params.user = &stream;
+    params.source = outline;
+    params.flatness = 0;
+    if(config && config->flatness > 0.f)
+        params.flatness = (PVG_FT_Pos)plutovg_max(1.f, roundf(config->flatness * 64));
+    if(clip_rect) {
+        params.flags |= PVG_FT_RASTER_FLAG_CLIP;
+        params.clip_box.xMin = (PVG_FT_Pos)clip_rect->x;
+        params.clip_box.yMin = (PVG_FT_Pos)clip_rect->y;
+        params.clip_box.xMax = (PVG_FT_Pos)(clip_rect->x + clip_rect->w);
+        params.clip_box.yMax = (PVG_FT_Pos)(clip_rect->y + clip_rect->h);
+    }
+
+    if(pool == NULL) {
+        PVG_FT_Raster_Render(&params, NULL);
+        return;
+    }
+
+    PVG_FT_Raster_Pool ft_pool = {pool->buffer, pool->size};
+    PVG_FT_Raster_Render(&params, &ft_pool);
+    pool->buffer = ft_pool.buffer;
+    pool->size = ft_pool.size;
+}
+
+static bool path_get_rect(const plutovg_path_t* path, const plutovg_matrix_t* matrix, PVG_FT_BBox* box, bool* clockwise)
+{
+    if(matrix->b != 0.f || matrix->c != 0.f || path->num_contours != 1 || path->num_curves > 0 || path->num_points > 6)
+        return false;
+    plutovg_point_t points[5];
+    int count = 0;
+
+    plutovg_path_iterator_t it;
+    plutovg_path_iterator_init(&it, path);
+    while(plutovg_path_iterator_has_next(&it)) {
+        plutovg_point_t p[3];
+        plutovg_path_command_t command = plutovg_path_iterator_next(&it, p);
+        if(command == PLUTOVG_PATH_COMMAND_CLOSE) {
+            if(plutovg_path_iterator_has_next(&it))
+                return false;
+            break;
+        }
+
+        if(count == 5 || (command == PLUTOVG_PATH_COMMAND_MOVE_TO) != (count == 0))
+            return false;
+        points[count++] = p[0];
+    }
+
+    if(count == 5) {
+        if(points[4].x != points[0].x || points[4].y != points[0].y) {
+            return false;
+        }
+    } else if(count != 4) {
+        return false;
+    }
+
+    if(!(points[0].y == points[1].y && points[1].x == points[2].x && points[2].y == points[3].y && points[3].x == points[0].x)
+        && !(points[0].x == points[1].x && points[1].y == points[2].y && points[2].x == points[3].x && points[3].y == points[0].y)) {
+        return false;
+    }
+
+    plutovg_point_t corners[3];
+    plutovg_matrix_map_point(matrix, &points[0], &corners[0]);
+    plutovg_matrix_map_point(matrix, &points[1], &corners[1]);
+    plutovg_matrix_map_point(matrix, &points[2], &corners[2]);
+
+    PVG_FT_Pos x1 = FT_COORD(corners[0].x);
+    PVG_FT_Pos y1 = FT_COORD(corners[0].y);
+    PVG_FT_Pos x2 = FT_COORD(corners[2].x);
+    PVG_FT_Pos y2 = FT_COORD(corners[2].y);
+    box->xMin = plutovg_min(x1, x2);
+    box->yMin = plutovg_min(y1, y2);
+    box->xMax = plutovg_max(x1, x2);
+    box->yMax = plutovg_max(y1, y2);
+
+    float dx1 = corners[1].x - corners[0].x;
+    float dy1 = corners[1].y - corners[0].y;
+    float dx2 = corners[2].x - corners[1].x;
+    float dy2 = corners[2].y - corners[1].y;
+    *clockwise = dx1 * dy2 - dy1 * dx2 > 0.f;
+    return true;
+}
+
+static inline int rect_coverage(PVG_FT_Pos fx, PVG_FT_Pos fy, bool clockwise)
+{
+    /* the cell rasterizer truncates the signed area, which rounds clockwise rectangles up */
+    PVG_FT_Pos area = fx * fy;
+    if(clockwise)
+        area += 15;
+    return plutovg_min((int)(area >> 4), 255);
+}
+
+/*
+ * Emits the spans of an axis-aligned rectangle directly. Coordinates are
+ * snapped to the same 26.6 grid and the coverage uses the same integer
+ * area formula as the cell rasterizer, so the output is identical to it.
+ */
+static void rect_render(plutovg_span_func_t span_func, void* closure, const PVG_FT_BBox* rect, bool clockwise, const plutovg_rect_t* clip_rect)
+{
+    PVG_FT_BBox box = *rect;
+    if(clip_rect) {
+        box.xMin = plutovg_max(box.xMin, (PVG_FT_Pos)clip_rect->x * 64);
+        box.yMin = plutovg_max(box.yMin, (PVG_FT_Pos)clip_rect->y * 64);
+        box.xMax = plutovg_min(box.xMax, (PVG_FT_Pos)(clip_rect->x + clip_rect->w) * 64);
+        box.yMax = plutovg_min(box.yMax, (PVG_FT_Pos)(clip_rect->y + clip_rect->h) * 64);
+    }
+
+    if(box.xMax <= box.xMin || box.yMax <= box.yMin)
+        return;
+    int ex1 = (int)(box.xMin >> 6);
+    int ex2 = (int)((box.xMax - 1) >> 6);
+    int ey1 = (int)(box.yMin >> 6);
+    int ey2 = (int)((box.yMax - 1) >> 6);
+
+    PVG_FT_Pos left = ex1 == ex2 ? box.xMax - box.xMin : ((PVG_FT_Pos)(ex1 + 1) << 6) - box.xMin;
+    PVG_FT_Pos right = box.xMax - ((PVG_FT_Pos)ex2 << 6);
+
+    plutovg_span_t spans[256];
+    int count = 0;
+    for(int ey = ey1; ey <= ey2; ey++) {
+        PVG_FT_Pos fy = plutovg_min(box.yMax, (PVG_FT_Pos)(ey + 1) << 6) - plutovg_max(box.yMin, (PVG_FT_Pos)ey << 6);
+        if(count > 256 - 3) {
+            span_func(count, spans, closure);
+            count = 0;
+        }
+
+        int x = ex1;
+        int coverage = rect_coverage(left, fy, clockwise);
+        if(ex1 < ex2) {
+            int middle = rect_coverage(64, fy, clockwise);
+            if(coverage != middle) {
+                spans[count].x = x;
+                spans[count].len = 1;
+                spans[count].y = ey;
+                spans[count].coverage = coverage;
+                count += coverage > 0;
+                x += 1;
+            }
+
+            int end = right == 64 ? ex2 + 1 : ex2;
+            if(end > x) {
+                spans[count].x = x;
+                spans[count].len = end - x;
+                spans[count].y = ey;
+                spans[count].coverage = middle;
+                count += middle > 0;
+                x = end;
+            }
+
+            coverage = rect_coverage(right, fy, clockwise);
+        }
+
+        if(x == ex2) {
+            spans[count].x = x;
+            spans[count].len = 1;
+            spans[count].y = ey;
+            spans[count].coverage = coverage;
+            count += coverage > 0;
+        }
+    }
+
+    if(count > 0) {
+        span_func(count, spans, closure);
+    }
+}
+
+void plutovg_rasterize_spans(plutovg_span_func_t span_func, void* closure, const plutovg_path_t* path, const plutovg_matrix_t* matrix, const plutovg_rect_t* clip_rect, const plutovg_stroke_data_t* stroke_data, plutovg_fill_rule_t winding, const plutovg_raster_config_t* config, plutovg_raster_pool_t* pool)
+{
+    PVG_FT_BBox rect;
+    bool clockwise;
+    if(stroke_data == NULL && path_get_rect(path, matrix, &rect, &clockwise)) {
+        rect_render(span_func, closure, &rect, clockwise, clip_rect);
+        return;
+    }
+
+    PVG_FT_Outline* outline;
     if(stroke_data) {
+        float flatness = config ? config->flatness : 0.f;
+        outline = ft_outline_convert_stroke(path, matrix, stroke_data, flatness);
         outline->flags = PVG_FT_OUTLINE_NONE;
     } else {
+        outline = ft_outline_convert(path, matrix, 0.f);
         switch(winding) {
         case PLUTOVG_FILL_RULE_EVEN_ODD:
             outline->flags = PVG_FT_OUTLINE_EVEN_ODD_FILL;
@@ -375,20 +1407,54 @@ void plutovg_rasterize(plutovg_span_buffer_t* span_buffer, const plutovg_path_t*
         }
     }
 
-    PVG_FT_Raster_Params params;
-    params.flags = PVG_FT_RASTER_FLAG_DIRECT | PVG_FT_RASTER_FLAG_AA;
-    params.gray_spans = spans_generation_callback;
-    params.user = span_buffer;
-    params.source = outline;
-    if(clip_rect) {
-        params.flags |= PVG_FT_RASTER_FLAG_CLIP;
-        params.clip_box.xMin = (PVG_FT_Pos)clip_rect->x;
-        params.clip_box.yMin = (PVG_FT_Pos)clip_rect->y;
-        params.clip_box.xMax = (PVG_FT_Pos)(clip_rect->x + clip_rect->w);
-        params.clip_box.yMax = (PVG_FT_Pos)(clip_rect->y + clip_rect->h);
+    ft_outline_render(span_func, closure, outline, clip_rect, config, pool);
+    ft_outline_destroy(outline);
+}
+
+void plutovg_rasterize(plutovg_span_buffer_t* span_buffer, const plutovg_path_t* path, const plutovg_matrix_t* matrix, const plutovg_rect_t* clip_rect, const plutovg_stroke_data_t* stroke_data, plutovg_fill_rule_t winding, const plutovg_raster_config_t* config, plutovg_raster_pool_t* pool)
+{
+    plutovg_span_buffer_reset(span_buffer);
+    plutovg_rasterize_spans(spans_generation_callback, span_buffer, path, matrix, clip_rect, stroke_data, winding, config, pool);
+}
+
+#if PLUTOVG_OUTLINE_TAG_ON != PVG_FT_CURVE_TAG_ON || PLUTOVG_OUTLINE_TAG_CUBIC != PVG_FT_CURVE_TAG_CUBIC
+#error "plutovg outline tags must match the rasterizer tags"
+#endif
+
+void plutovg_rasterize_outlines(plutovg_span_buffer_t* span_buffer, const plutovg_outline_t* const* outlines, const plutovg_matrix_t* matrices, int count, const plutovg_rect_t* clip_rect, plutovg_fill_rule_t winding, const plutovg_raster_config_t* config, plutovg_raster_pool_t* pool)
+{
+    int num_points = 0;
+    int num_contours = 0;
+    for(int i = 0; i < count; ++i) {
+        num_points += outlines[i]->num_points;
+        num_contours += outlines[i]->num_contours;
+    }
+
+    PVG_FT_Outline* outline = ft_outline_create(num_points, num_contours);
+    for(int i = 0; i < count; ++i) {
+        const plutovg_outline_t* source = outlines[i];
+        const plutovg_matrix_t* matrix = &matrices[i];
+        PVG_FT_Vector* points = outline->points + outline->n_points;
+        for(int j = 0; j < source->num_points; ++j) {
+            const plutovg_point_t* point = &source->points[j];
+            float x = matrix->a * point->x + matrix->c * point->y + matrix->e;
+            float y = matrix->b * point->x + matrix->d * point->y + matrix->f;
+            points[j].x = FT_COORD(x);
+            points[j].y = FT_COORD(y);
+        }
+
+        memcpy(outline->tags + outline->n_points, source->tags, source->num_points);
+        for(int j = 0; j < source->num_contours; ++j) {
+            outline->contours[outline->n_contours] = outline->n_points + source->contours[j];
+            outline->contours_flag[outline->n_contours] = 1;
+            outline->n_contours++;
+        }
+
+        outline->n_points += source->num_points;
     }
 
+    outline->flags = winding == PLUTOVG_FILL_RULE_EVEN_ODD ? PVG_FT_OUTLINE_EVEN_ODD_FILL : PVG_FT_OUTLINE_NONE;
     plutovg_span_buffer_reset(span_buffer);
-    PVG_FT_Raster_Render(&params);
+    ft_outline_render(spans_generation_callback, span_buffer, outline, clip_rect, config, pool);
     ft_outline_destroy(outline);
 }
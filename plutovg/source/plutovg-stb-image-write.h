@@ -42,24 +42,25 @@ UNICODE:
 
 USAGE:
 
-   There are five functions, one for each image file format:
+   There are four file functions, one for each image file format except JPEG:
 
      int stbi_write_png(char const *filename, int w, int h, int comp, const void *data, int stride_in_bytes);
      int stbi_write_bmp(char const *filename, int w, int h, int comp, const void *data);
      int stbi_write_tga(char const *filename, int w, int h, int comp, const void *data);
-     int stbi_write_jpg(char const *filename, int w, int h, int comp, const void *data, int quality);
      int stbi_write_hdr(char const *filename, int w, int h, int comp, const float *data);
 
      void stbi_flip_vertically_on_write(int flag); // flag is non-zero to flip data vertically
 
-   There are also five equivalent functions that use an arbitrary write function. You are
-   expected to open/close your file-equivalent before and after calling these:
+   There are also five functions that use an arbitrary write function. You are
+   expected to open/close your file-equivalent before and after calling these.
+   The JPEG writer pulls its input a band of rows at a time through 'rows_func'
+   instead of reading a whole image, so it ignores stbi_flip_vertically_on_write:
 
      int stbi_write_png_to_func(stbi_write_func *func, void *context, int w, int h, int comp, const void  *data, int stride_in_bytes);
      int stbi_write_bmp_to_func(stbi_write_func *func, void *context, int w, int h, int comp, const void  *data);
      int stbi_write_tga_to_func(stbi_write_func *func, void *context, int w, int h, int comp, const void  *data);
      int stbi_write_hdr_to_func(stbi_write_func *func, void *context, int w, int h, int comp, const float *data);
-     int stbi_write_jpg_to_func(stbi_write_func *func, void *context, int x, int y, int comp, const void *data, int quality);
+     int stbi_write_jpg_rows_to_func(stbi_write_func *func, void *context, int x, int y, int comp, stbi_write_rows_func *rows_func, void *rows_context, int quality);
 
    where the callback is:
       void stbi_write_func(void *context, void *data, int size);
@@ -74,6 +75,9 @@ USAGE:
    functions, so the library will not use stdio.h at all. However, this will
    also disable HDR writing, because it requires stdio for formatted output.
 
+   You can define STBI_WRITE_NO_PNG to leave out the PNG writer, together
+   with its zlib compressor and the PNG global variables.
+
    Each function returns 0 on failure and non-0 on success.
 
    The functions create an image file defined by the parameters. The image
@@ -168,16 +172,19 @@ LICENSE
 
 #ifndef STB_IMAGE_WRITE_STATIC  // C++ forbids static forward declarations
 STBIWDEF int stbi_write_tga_with_rle;
+#ifndef STBI_WRITE_NO_PNG
 STBIWDEF int stbi_write_png_compression_level;
 STBIWDEF int stbi_write_force_png_filter;
 #endif
+#endif
 
 #ifndef STBI_WRITE_NO_STDIO
+#ifndef STBI_WRITE_NO_PNG
 STBIWDEF int stbi_write_png(char const *filename, int w, int h, int comp, const void  *data, int stride_in_bytes);
+#endif
 STBIWDEF int stbi_write_bmp(char const *filename, int w, int h, int comp, const void  *data);
 STBIWDEF int stbi_write_tga(char const *filename, int w, int h, int comp, const void  *data);
 STBIWDEF int stbi_write_hdr(char const *filename, int w, int h, int comp, const float *data);
-STBIWDEF int stbi_write_jpg(char const *filename, int x, int y, int comp, const void  *data, int quality);
 
 #ifdef STBIW_WINDOWS_UTF8
 STBIWDEF int stbiw_convert_wchar_to_utf8(char *buffer, size_t bufferlen, const wchar_t* input);
@@ -186,11 +193,17 @@ STBIWDEF int stbiw_convert_wchar_to_utf8(char *buffer, size_t bufferlen, const w
 
 typedef void stbi_write_func(void *context, void *data, int size);
 
+#ifndef STBI_WRITE_NO_PNG
 STBIWDEF int stbi_write_png_to_func(stbi_write_func *func, void *context, int w, int h, int comp, const void  *data, int stride_in_bytes);
+#endif
 STBIWDEF int stbi_write_bmp_to_func(stbi_write_func *func, void *context, int w, int h, int comp, const void  *data);
 STBIWDEF int stbi_write_tga_to_func(stbi_write_func *func, void *context, int w, int h, int comp, const void  *data);
 STBIWDEF int stbi_write_hdr_to_func(stbi_write_func *func, void *context, int w, int h, int comp, const float *data);
-STBIWDEF int stbi_write_jpg_to_func(stbi_write_func *func, void *context, int x, int y, int comp, const void  *data, int quality);
+
+// fills 'count' rows starting at 'y' into 'rows', tightly packed with w*comp bytes per row
+typedef void stbi_write_rows_func(void *context, unsigned char *rows, int y, int count);
+
+STBIWDEF int stbi_write_jpg_rows_to_func(stbi_write_func *func, void *context, int x, int y, int comp, stbi_write_rows_func *rows_func, void *rows_context, int quality);
 
 STBIWDEF void stbi_flip_vertically_on_write(int flip_boolean);
 
@@ -248,14 +261,18 @@ STBIWDEF void stbi_flip_vertically_on_write(int flip_boolean);
 #define STBIW_UCHAR(x) (unsigned char) ((x) & 0xff)
 
 #ifdef STB_IMAGE_WRITE_STATIC
-static int stbi_write_png_compression_level = 8;
 static int stbi_write_tga_with_rle = 1;
+#ifndef STBI_WRITE_NO_PNG
+static int stbi_write_png_compression_level = 8;
 static int stbi_write_force_png_filter = -1;
+#endif
 #else
-int stbi_write_png_compression_level = 8;
 int stbi_write_tga_with_rle = 1;
+#ifndef STBI_WRITE_NO_PNG
+int stbi_write_png_compression_level = 8;
 int stbi_write_force_png_filter = -1;
 #endif
+#endif
 
 static int stbi__flip_vertically_on_write = 0;
 
@@ -804,6 +821,8 @@ STBIWDEF int stbi_write_hdr(char const *filename, int x, int y, int comp, const
 #endif // STBI_WRITE_NO_STDIO
 
 
+#ifndef STBI_WRITE_NO_PNG
+
 //////////////////////////////////////////////////////////////////////////////
 //
 // PNG writer
@@ -1238,6 +1257,8 @@ STBIWDEF int stbi_write_png_to_func(stbi_write_func *func, void *context, int x,
    return 1;
 }
 
+#endif // STBI_WRITE_NO_PNG
+
 
 /* ***************************************************************************
  *
@@ -1395,7 +1416,7 @@ static int stbiw__jpg_processDU(stbi__write_context *s, int *bitBuf, int *bitCnt
    return DU[0];
 }
 
-static int stbi_write_jpg_core(stbi__write_context *s, int width, int height, int comp, const void* data, int quality) {
+static int stbi_write_jpg_core(stbi__write_context *s, int width, int height, int comp, stbi_write_rows_func *rows_func, void *rows_context, int quality) {
    // Constants that don't pollute global namespace
    static const unsigned char std_dc_luminance_nrcodes[] = {0,0,1,5,1,1,1,1,1,1,0,0,0,0,0,0,0};
    static const unsigned char std_dc_luminance_values[] = {0,1,2,3,4,5,6,7,8,9,10,11};
@@ -1470,13 +1491,19 @@ static int stbi_write_jpg_core(stbi__write_context *s, int width, int height, in
    int row, col, i, k, subsample;
    float fdtbl_Y[64], fdtbl_UV[64];
    unsigned char YTable[64], UVTable[64];
+   unsigned char *band;
 
-   if(!data || !width || !height || comp > 4 || comp < 1) {
+   if(!rows_func || !width || !height || comp > 4 || comp < 1) {
       return 0;
    }
 
    quality = quality ? quality : 90;
    subsample = quality <= 90 ? 1 : 0;
+   // only one band of macroblock rows is held at a time
+   band = (unsigned char *) STBIW_MALLOC(width * comp * (subsample ? 16 : 8));
+   if(!band)
+      return 0;
+
    quality = quality < 1 ? 1 : quality > 100 ? 100 : quality;
    quality = quality < 50 ? 5000 / quality : 200 - quality * 2;
 
@@ -1526,18 +1553,19 @@ static int stbi_write_jpg_core(stbi__write_context *s, int width, int height, in
       int bitBuf=0, bitCnt=0;
       // comp == 2 is grey+alpha (alpha is ignored)
       int ofsG = comp > 2 ? 1 : 0, ofsB = comp > 2 ? 2 : 0;
-      const unsigned char *dataR = (const unsigned char *)data;
+      const unsigned char *dataR = band;
       const unsigned char *dataG = dataR + ofsG;
       const unsigned char *dataB = dataR + ofsB;
       int x, y, pos;
       if(subsample) {
          for(y = 0; y < height; y += 16) {
+            rows_func(rows_context, band, y, height - y < 16 ? height - y : 16);
             for(x = 0; x < width; x += 16) {
                float Y[256], U[256], V[256];
                for(row = y, pos = 0; row < y+16; ++row) {
                   // row >= height => use last input row
                   int clamped_row = (row < height) ? row : height - 1;
-                  int base_p = (stbi__flip_vertically_on_write ? (height-1-clamped_row) : clamped_row)*width*comp;
+                  int base_p = (clamped_row-y)*width*comp;
                   for(col = x; col < x+16; ++col, ++pos) {
                      // if col >= width => use pixel from last input column
                      int p = base_p + ((col < width) ? col : (width-1))*comp;
@@ -1570,12 +1598,13 @@ static int stbi_write_jpg_core(stbi__write_context *s, int width, int height, in
          }
       } else {
          for(y = 0; y < height; y += 8) {
+            rows_func(rows_context, band, y, height - y < 8 ? height - y : 8);
             for(x = 0; x < width; x += 8) {
                float Y[64], U[64], V[64];
                for(row = y, pos = 0; row < y+8; ++row) {
                   // row >= height => use last input row
                   int clamped_row = (row < height) ? row : height - 1;
-                  int base_p = (stbi__flip_vertically_on_write ? (height-1-clamped_row) : clamped_row)*width*comp;
+                  int base_p = (clamped_row-y)*width*comp;
                   for(col = x; col < x+8; ++col, ++pos) {
                      // if col >= width => use pixel from last input column
                      int p = base_p + ((col < width) ? col : (width-1))*comp;
@@ -1601,29 +1630,16 @@ static int stbi_write_jpg_core(stbi__write_context *s, int width, int height, in
    stbiw__putc(s, 0xFF);
    stbiw__putc(s, 0xD9);
 
+   STBIW_FREE(band);
    return 1;
 }
 
-STBIWDEF int stbi_write_jpg_to_func(stbi_write_func *func, void *context, int x, int y, int comp, const void *data, int quality)
+STBIWDEF int stbi_write_jpg_rows_to_func(stbi_write_func *func, void *context, int x, int y, int comp, stbi_write_rows_func *rows_func, void *rows_context, int quality)
 {
    stbi__write_context s = { 0 };
    stbi__start_write_callbacks(&s, func, context);
-   return stbi_write_jpg_core(&s, x, y, comp, (void *) data, quality);
-}
-
-
-#ifndef STBI_WRITE_NO_STDIO
-STBIWDEF int stbi_write_jpg(char const *filename, int x, int y, int comp, const void *data, int quality)
-{
-   stbi__write_context s = { 0 };
-   if (stbi__start_write_file(&s,filename)) {
-      int r = stbi_write_jpg_core(&s, x, y, comp, data, quality);
-      stbi__end_write_file(&s);
-      return r;
-   } else
-      return 0;
+   return stbi_write_jpg_core(&s, x, y, comp, rows_func, rows_context, quality);
 }
-#endif
 
 #endif // STB_IMAGE_WRITE_IMPLEMENTATION
 
@@ -1,8 +1,11 @@
 #include "plutovg-private.h"
 #include "plutovg-utils.h"
 
+#include <stdio.h>
+
 #define STB_IMAGE_WRITE_STATIC
 #define STB_IMAGE_WRITE_IMPLEMENTATION
+#define STBI_WRITE_NO_PNG
 #include "plutovg-stb-image-write.h"
 
 #define STB_IMAGE_STATIC
@@ -23,6 +26,7 @@ static plutovg_surface_t* plutovg_surface_create_uninitialized(int width, int he
     surface->height = height;
     surface->stride = width * 4;
     surface->data = (uint8_t*)(surface + 1);
+    plutovg_atomic_pointer_init(&surface->mipmap, NULL);
     return surface;
 }
 
@@ -42,6 +46,7 @@ plutovg_surface_t* plutovg_surface_create_for_data(unsigned char* data, int widt
     surface->height = height;
     surface->stride = stride;
     surface->data = data;
+    plutovg_atomic_pointer_init(&surface->mipmap, NULL);
     return surface;
 }
 
@@ -157,6 +162,7 @@ plutovg_surface_t* plutovg_surface_reference(plutovg_surface_t* surface)
 void plutovg_surface_destroy(plutovg_surface_t* surface)
 {
     if(plutovg_destroy_reference(surface)) {
+        plutovg_surface_destroy(plutovg_atomic_pointer_load(&surface->mipmap));
         free(surface);
     }
 }
@@ -193,63 +199,359 @@ void plutovg_surface_clear(plutovg_surface_t* surface, const plutovg_color_t* co
         uint32_t* pixels = (uint32_t*)(surface->data + surface->stride * y);
         plutovg_memfill32(pixels, surface->width, pixel);
     }
+
+    plutovg_surface_mark_dirty(surface);
 }
 
-static void plutovg_surface_write_begin(const plutovg_surface_t* surface)
+void plutovg_surface_mark_dirty(plutovg_surface_t* surface)
 {
-    plutovg_convert_argb_to_rgba(surface->data, surface->data, surface->width, surface->height, surface->stride);
+    plutovg_surface_t* mipmap = plutovg_atomic_pointer_load(&surface->mipmap);
+    if(mipmap) {
+        plutovg_atomic_pointer_store(&surface->mipmap, NULL);
+        plutovg_surface_destroy(mipmap);
+    }
 }
 
-static void plutovg_surface_write_end(const plutovg_surface_t* surface)
+static inline uint32_t plutovg_average_4_pixels(uint32_t a, uint32_t b, uint32_t c, uint32_t d)
 {
-    plutovg_convert_rgba_to_argb(surface->data, surface->data, surface->width, surface->height, surface->stride);
+    uint32_t rb = (a & 0xff00ff) + (b & 0xff00ff) + (c & 0xff00ff) + (d & 0xff00ff) + 0x20002;
+    uint32_t ag = ((a >> 8) & 0xff00ff) + ((b >> 8) & 0xff00ff) + ((c >> 8) & 0xff00ff) + ((d >> 8) & 0xff00ff) + 0x20002;
+    return ((ag << 6) & 0xff00ff00) | ((rb >> 2) & 0xff00ff);
 }
 
-bool plutovg_surface_write_to_png(const plutovg_surface_t* surface, const char* filename)
+/*
+ * Returns the next mipmap level of the surface, half its size with each pixel
+ * the average of a 2x2 block, building it on first use. The level is kept
+ * until the surface is destroyed or marked dirty. Shared surfaces may be
+ * sampled from several threads at once, so the level is published with a
+ * compare-and-swap and a thread that loses the race drops its own copy.
+ */
+plutovg_surface_t* plutovg_surface_get_mipmap(plutovg_surface_t* surface)
 {
-    plutovg_surface_write_begin(surface);
-    int success = stbi_write_png(filename, surface->width, surface->height, 4, surface->data, surface->stride);
-    plutovg_surface_write_end(surface);
-    return success;
+    plutovg_surface_t* mipmap = plutovg_atomic_pointer_load(&surface->mipmap);
+    if(mipmap || (surface->width == 1 && surface->height == 1))
+        return mipmap;
+    mipmap = plutovg_surface_create_uninitialized(plutovg_max(1, surface->width / 2), plutovg_max(1, surface->height / 2));
+    if(mipmap == NULL)
+        return NULL;
+    for(int y = 0; y < mipmap->height; y++) {
+        const uint32_t* row1 = (const uint32_t*)(surface->data + surface->stride * (2 * y));
+        const uint32_t* row2 = (const uint32_t*)(surface->data + surface->stride * plutovg_min(2 * y + 1, surface->height - 1));
+        uint32_t* target = (uint32_t*)(mipmap->data + mipmap->stride * y);
+        for(int x = 0; x < mipmap->width; x++) {
+            int x1 = 2 * x;
+            int x2 = plutovg_min(x1 + 1, surface->width - 1);
+            target[x] = plutovg_average_4_pixels(row1[x1], row1[x2], row2[x1], row2[x2]);
+        }
+    }
+
+    if(!plutovg_atomic_pointer_set_if_null(&surface->mipmap, mipmap)) {
+        plutovg_surface_destroy(mipmap);
+        mipmap = plutovg_atomic_pointer_load(&surface->mipmap);
+    }
+
+    return mipmap;
 }
 
-bool plutovg_surface_write_to_jpg(const plutovg_surface_t* surface, const char* filename, int quality)
+static void plutovg_surface_jpg_rows_func(void* context, unsigned char* rows, int y, int count)
 {
-    plutovg_surface_write_begin(surface);
-    int success = stbi_write_jpg(filename, surface->width, surface->height, 4, surface->data, quality);
-    plutovg_surface_write_end(surface);
-    return success;
+    const plutovg_surface_t* surface = context;
+    plutovg_convert_argb_to_format(rows, surface->width * 4, surface->data + surface->stride * y, surface->stride, surface->width, count, PLUTOVG_PIXEL_FORMAT_RGBA32);
 }
 
 bool plutovg_surface_write_to_png_stream(const plutovg_surface_t* surface, plutovg_write_func_t write_func, void* closure)
 {
-    plutovg_surface_write_begin(surface);
-    int success = stbi_write_png_to_func(write_func, closure, surface->width, surface->height, 4, surface->data, surface->stride);
-    plutovg_surface_write_end(surface);
-    return success;
+    return plutovg_png_encode(surface, write_func, closure, PLUTOVG_PNG_DEFAULT_COMPRESSION_LEVEL, PLUTOVG_PNG_FILTER_ADAPTIVE);
 }
 
 bool plutovg_surface_write_to_jpg_stream(const plutovg_surface_t* surface, plutovg_write_func_t write_func, void* closure, int quality)
 {
-    plutovg_surface_write_begin(surface);
-    int success = stbi_write_jpg_to_func(write_func, closure, surface->width, surface->height, 4, surface->data, quality);
-    plutovg_surface_write_end(surface);
-    return success;
+    return stbi_write_jpg_rows_to_func(write_func, closure, surface->width, surface->height, 4, plutovg_surface_jpg_rows_func, (void*)(surface), quality);
 }
 
-void plutovg_convert_argb_to_rgba(unsigned char* dst, const unsigned char* src, int width, int height, int stride)
+bool plutovg_surface_write_to_png_stream_with_options(const plutovg_surface_t* surface, plutovg_write_func_t write_func, void* closure, int compression_level, plutovg_png_filter_t filter)
 {
+    return plutovg_png_encode(surface, write_func, closure, compression_level, filter);
+}
+
+static void plutovg_store_u32_be(uint8_t* data, uint32_t value)
+{
+    data[0] = (value >> 24) & 0xFF;
+    data[1] = (value >> 16) & 0xFF;
+    data[2] = (value >> 8) & 0xFF;
+    data[3] = (value >> 0) & 0xFF;
+}
+
+bool plutovg_surface_write_to_qoi_stream(const plutovg_surface_t* surface, plutovg_write_func_t write_func, void* closure)
+{
+    const int width = surface->width;
+    const int height = surface->height;
+    uint8_t* pixels = malloc(width * 4 + width * 5);
+    if(pixels == NULL)
+        return false;
+    uint8_t* output = pixels + width * 4;
+
+    uint8_t header[14];
+    memcpy(header, "qoif", 4);
+    plutovg_store_u32_be(header + 4, width);
+    plutovg_store_u32_be(header + 8, height);
+    header[12] = 4;
+    header[13] = 0;
+    write_func(closure, header, sizeof(header));
+
+    uint8_t index[64][4];
+    memset(index, 0, sizeof(index));
+    uint8_t prev[4] = {0, 0, 0, 255};
+    int run = 0;
     for(int y = 0; y < height; y++) {
-        const uint32_t* src_row = (const uint32_t*)(src + stride * y);
-        unsigned char* dst_row = dst + stride * y;
+        plutovg_convert_argb_to_format(pixels, width * 4, surface->data + surface->stride * y, surface->stride, width, 1, PLUTOVG_PIXEL_FORMAT_RGBA32);
+        int length = 0;
+        for(int x = 0; x < width; x++) {
+            const uint8_t* px = pixels + x * 4;
+            if(memcmp(px, prev, 4) == 0) {
+                run++;
+                if(run == 62) {
+                    output[length++] = 0xC0 | (run - 1);
+                    run = 0;
+                }
+
+                continue;
+            }
+
+            if(run > 0) {
+                output[length++] = 0xC0 | (run - 1);
+                run = 0;
+            }
+
+            int hash = (px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64;
+            if(memcmp(index[hash], px, 4) == 0) {
+                output[length++] = hash;
+            } else {
+                memcpy(index[hash], px, 4);
+                if(px[3] == prev[3]) {
+                    int8_t vr = px[0] - prev[0];
+                    int8_t vg = px[1] - prev[1];
+                    int8_t vb = px[2] - prev[2];
+                    int8_t vg_r = vr - vg;
+                    int8_t vg_b = vb - vg;
+                    if(vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+                        output[length++] = 0x40 | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2);
+                    } else if(vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32 && vg_b > -9 && vg_b < 8) {
+                        output[length++] = 0x80 | (vg + 32);
+                        output[length++] = (vg_r + 8) << 4 | (vg_b + 8);
+                    } else {
+                        output[length++] = 0xFE;
+                        output[length++] = px[0];
+                        output[length++] = px[1];
+                        output[length++] = px[2];
+                    }
+                } else {
+                    output[length++] = 0xFF;
+                    memcpy(output + length, px, 4);
+                    length += 4;
+                }
+            }
+
+            memcpy(prev, px, 4);
+        }
+
+        if(length > 0) {
+            write_func(closure, output, length);
+        }
+    }
+
+    uint8_t footer[9] = {0, 0, 0, 0, 0, 0, 0, 0, 1};
+    if(run > 0) {
+        footer[0] = 0xC0 | (run - 1);
+        write_func(closure, footer, 1);
+        footer[0] = 0;
+    }
+
+    write_func(closure, footer + 1, 8);
+    free(pixels);
+    return true;
+}
+
+static bool plutovg_surface_write_to_netpbm_stream(const plutovg_surface_t* surface, plutovg_write_func_t write_func, void* closure, bool alpha)
+{
+    const int width = surface->width;
+    const int height = surface->height;
+    uint8_t* pixels = malloc(width * 4);
+    if(pixels == NULL)
+        return false;
+    char header[128];
+    int length;
+    if(alpha) {
+        length = snprintf(header, sizeof(header), "P7\nWIDTH %d\nHEIGHT %d\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n", width, height);
+    } else {
+        length = snprintf(header, sizeof(header), "P6\n%d %d\n255\n", width, height);
+    }
+
+    write_func(closure, header, length);
+    for(int y = 0; y < height; y++) {
+        const uint8_t* row = surface->data + surface->stride * y;
+        if(alpha) {
+            plutovg_convert_argb_to_format(pixels, width * 4, row, surface->stride, width, 1, PLUTOVG_PIXEL_FORMAT_RGBA32);
+            write_func(closure, pixels, width * 4);
+        } else {
+            const uint32_t* src = (const uint32_t*)(row);
+            for(int x = 0; x < width; x++) {
+                pixels[x * 3 + 0] = (src[x] >> 16) & 0xFF;
+                pixels[x * 3 + 1] = (src[x] >> 8) & 0xFF;
+                pixels[x * 3 + 2] = (src[x] >> 0) & 0xFF;
+            }
+
+            write_func(closure, pixels, width * 3);
+        }
+    }
+
+    free(pixels);
+    return true;
+}
+
+bool plutovg_surface_write_to_pam_stream(const plutovg_surface_t* surface, plutovg_write_func_t write_func, void* closure)
+{
+    return plutovg_surface_write_to_netpbm_stream(surface, write_func, closure, true);
+}
+
+bool plutovg_surface_write_to_ppm_stream(const plutovg_surface_t* surface, plutovg_write_func_t write_func, void* closure)
+{
+    return plutovg_surface_write_to_netpbm_stream(surface, write_func, closure, false);
+}
+
+typedef enum {
+    PLUTOVG_FILE_FORMAT_PNG,
+    PLUTOVG_FILE_FORMAT_JPG,
+    PLUTOVG_FILE_FORMAT_QOI,
+    PLUTOVG_FILE_FORMAT_PAM,
+    PLUTOVG_FILE_FORMAT_PPM
+} plutovg_file_format_t;
+
+static void plutovg_file_write_func(void* closure, void* data, int size)
+{
+    fwrite(data, 1, size, (FILE*)(closure));
+}
+
+static bool plutovg_surface_write_to_file(const plutovg_surface_t* surface, const char* filename, plutovg_file_format_t format, int level, plutovg_png_filter_t filter)
+{
+    FILE* fp = fopen(filename, "wb");
+    if(fp == NULL)
+        return false;
+    bool success = false;
+    switch(format) {
+    case PLUTOVG_FILE_FORMAT_PNG:
+        success = plutovg_png_encode(surface, plutovg_file_write_func, fp, level, filter);
+        break;
+    case PLUTOVG_FILE_FORMAT_JPG:
+        success = plutovg_surface_write_to_jpg_stream(surface, plutovg_file_write_func, fp, level);
+        break;
+    case PLUTOVG_FILE_FORMAT_QOI:
+        success = plutovg_surface_write_to_qoi_stream(surface, plutovg_file_write_func, fp);
+        break;
+    case PLUTOVG_FILE_FORMAT_PAM:
+        success = plutovg_surface_write_to_pam_stream(surface, plutovg_file_write_func, fp);
+        break;
+    case PLUTOVG_FILE_FORMAT_PPM:
+        success = plutovg_surface_write_to_ppm_stream(surface, plutovg_file_write_func, fp);
+        break;
+    }
+
+    success &= !ferror(fp);
+    success &= fclose(fp) == 0;
+    return success;
+}
+
+bool plutovg_surface_write_to_png(const plutovg_surface_t* surface, const char* filename)
+{
+    return plutovg_surface_write_to_file(surface, filename, PLUTOVG_FILE_FORMAT_PNG, PLUTOVG_PNG_DEFAULT_COMPRESSION_LEVEL, PLUTOVG_PNG_FILTER_ADAPTIVE);
+}
+
+bool plutovg_surface_write_to_png_with_options(const plutovg_surface_t* surface, const char* filename, int compression_level, plutovg_png_filter_t filter)
+{
+    return plutovg_surface_write_to_file(surface, filename, PLUTOVG_FILE_FORMAT_PNG, compression_level, filter);
+}
+
+bool plutovg_surface_write_to_jpg(const plutovg_surface_t* surface, const char* filename, int quality)
+{
+    return plutovg_surface_write_to_file(surface, filename, PLUTOVG_FILE_FORMAT_JPG, quality, PLUTOVG_PNG_FILTER_ADAPTIVE);
+}
+
+bool plutovg_surface_write_to_qoi(const plutovg_surface_t* surface, const char* filename)
+{
+    return plutovg_surface_write_to_file(surface, filename, PLUTOVG_FILE_FORMAT_QOI, 0, PLUTOVG_PNG_FILTER_ADAPTIVE);
+}
+
+bool plutovg_surface_write_to_pam(const plutovg_surface_t* surface, const char* filename)
+{
+    return plutovg_surface_write_to_file(surface, filename, PLUTOVG_FILE_FORMAT_PAM, 0, PLUTOVG_PNG_FILTER_ADAPTIVE);
+}
+
+bool plutovg_surface_write_to_ppm(const plutovg_surface_t* surface, const char* filename)
+{
+    return plutovg_surface_write_to_file(surface, filename, PLUTOVG_FILE_FORMAT_PPM, 0, PLUTOVG_PNG_FILTER_ADAPTIVE);
+}
+
+int plutovg_pixel_format_get_bytes_per_pixel(plutovg_pixel_format_t format)
+{
+    if(format == PLUTOVG_PIXEL_FORMAT_A8)
+        return 1;
+    return 4;
+}
+
+static inline bool plutovg_is_little_endian(void)
+{
+    const uint16_t value = 1;
+    return *(const uint8_t*)(&value) == 1;
+}
+
+bool plutovg_pixel_format_is_native(plutovg_pixel_format_t format)
+{
+    if(format == PLUTOVG_PIXEL_FORMAT_BGRA32_PREMULTIPLIED)
+        return plutovg_is_little_endian();
+    return format == PLUTOVG_PIXEL_FORMAT_ARGB32_PREMULTIPLIED;
+}
+
+static void plutovg_convert_argb_row(unsigned char* dst, const unsigned char* src, int width, plutovg_pixel_format_t format)
+{
+    const uint32_t* src_row = (const uint32_t*)(src);
+    switch(format) {
+    case PLUTOVG_PIXEL_FORMAT_ARGB32_PREMULTIPLIED:
+        memmove(dst, src, width * 4);
+        break;
+    case PLUTOVG_PIXEL_FORMAT_BGRA32_PREMULTIPLIED:
+        if(plutovg_is_little_endian()) {
+            memmove(dst, src, width * 4);
+            break;
+        }
+
+        for(int x = 0; x < width; x++) {
+            uint32_t pixel = src_row[x];
+            *dst++ = (pixel >> 0) & 0xFF;
+            *dst++ = (pixel >> 8) & 0xFF;
+            *dst++ = (pixel >> 16) & 0xFF;
+            *dst++ = (pixel >> 24) & 0xFF;
+        }
+
+        break;
+    case PLUTOVG_PIXEL_FORMAT_RGBA32_PREMULTIPLIED:
+        for(int x = 0; x < width; x++) {
+            uint32_t pixel = src_row[x];
+            *dst++ = (pixel >> 16) & 0xFF;
+            *dst++ = (pixel >> 8) & 0xFF;
+            *dst++ = (pixel >> 0) & 0xFF;
+            *dst++ = (pixel >> 24) & 0xFF;
+        }
+
+        break;
+    case PLUTOVG_PIXEL_FORMAT_RGBA32:
         for(int x = 0; x < width; x++) {
             uint32_t pixel = src_row[x];
             uint32_t a = (pixel >> 24) & 0xFF;
             if(a == 0) {
-                *dst_row++ = 0;
-                *dst_row++ = 0;
-                *dst_row++ = 0;
-                *dst_row++ = 0;
+                *dst++ = 0;
+                *dst++ = 0;
+                *dst++ = 0;
+                *dst++ = 0;
             } else {
                 uint32_t r = (pixel >> 16) & 0xFF;
                 uint32_t g = (pixel >> 8) & 0xFF;
@@ -260,15 +562,43 @@ void plutovg_convert_argb_to_rgba(unsigned char* dst, const unsigned char* src,
                     b = (b * 255) / a;
                 }
 
-                *dst_row++ = r;
-                *dst_row++ = g;
-                *dst_row++ = b;
-                *dst_row++ = a;
+                *dst++ = r;
+                *dst++ = g;
+                *dst++ = b;
+                *dst++ = a;
             }
         }
+
+        break;
+    case PLUTOVG_PIXEL_FORMAT_A8:
+        for(int x = 0; x < width; x++) {
+            dst[x] = (src_row[x] >> 24) & 0xFF;
+        }
+
+        break;
+    }
+}
+
+void plutovg_convert_argb_to_format(unsigned char* dst, int dst_stride, const unsigned char* src, int src_stride, int width, int height, plutovg_pixel_format_t format)
+{
+    for(int y = 0; y < height; y++) {
+        plutovg_convert_argb_row(dst + dst_stride * y, src + src_stride * y, width, format);
     }
 }
 
+bool plutovg_surface_convert_to(const plutovg_surface_t* surface, unsigned char* data, int stride, plutovg_pixel_format_t format)
+{
+    if(stride < surface->width * plutovg_pixel_format_get_bytes_per_pixel(format))
+        return false;
+    plutovg_convert_argb_to_format(data, stride, surface->data, surface->stride, surface->width, surface->height, format);
+    return true;
+}
+
+void plutovg_convert_argb_to_rgba(unsigned char* dst, const unsigned char* src, int width, int height, int stride)
+{
+    plutovg_convert_argb_to_format(dst, stride, src, stride, width, height, PLUTOVG_PIXEL_FORMAT_RGBA32);
+}
+
 void plutovg_convert_rgba_to_argb(unsigned char* dst, const unsigned char* src, int width, int height, int stride)
 {
     for(int y = 0; y < height; y++) {
@@ -3,6 +3,7 @@
 
 #include <cfloat>
 #include <cmath>
+#include <cstdlib>
 
 namespace lunasvg {
 
@@ -414,9 +415,19 @@ plutovg_font_face_t* FontFace::release()
 
 bool FontFaceCache::addFontFace(const std::string& family, bool bold, bool italic, const FontFace& face)
 {
-    if(!face.isNull())
-        plutovg_font_face_cache_add(m_cache, family.data(), bold, italic, face.get());
-    return !face.isNull();
+    if(face.isNull())
+        return false;
+    plutovg_font_face_cache_add(m_cache, family.data(), bold, italic, face.get());
+    m_generation.fetch_add(1, std::memory_order_release);
+    return true;
+}
+
+int FontFaceCache::addFontCollection(const void* data, size_t length, plutovg_destroy_func_t destroy_func, void* closure)
+{
+    auto numFaces = plutovg_font_face_cache_load_data(m_cache, data, length, destroy_func, closure);
+    if(numFaces > 0)
+        m_generation.fetch_add(1, std::memory_order_release);
+    return numFaces;
 }
 
 FontFace FontFaceCache::getFontFace(const std::string& family, bool bold, bool italic) const
@@ -451,12 +462,32 @@ FontFace FontFaceCache::getFontFace(const std::string& family, bool bold, bool i
     return FontFace();
 }
 
+#ifndef LUNASVG_DISABLE_FONT_INDEX
+
+static std::string fontIndexFilename()
+{
+    if(auto filename = std::getenv("LUNASVG_FONT_INDEX"))
+        return filename;
+    return std::string();
+}
+
+#endif
+
 FontFaceCache::FontFaceCache()
     : m_cache(plutovg_font_face_cache_create())
 {
 #ifndef LUNASVG_DISABLE_LOAD_SYSTEM_FONTS
+#ifndef LUNASVG_DISABLE_FONT_INDEX
+    auto indexFilename = fontIndexFilename();
+    if(!indexFilename.empty()) {
+        plutovg_font_face_cache_load_sys_with_index(m_cache, indexFilename.data());
+    } else {
+        plutovg_font_face_cache_load_sys(m_cache);
+    }
+#else
     plutovg_font_face_cache_load_sys(m_cache);
 #endif
+#endif
 }
 
 FontFaceCache* fontFaceCache()
@@ -465,6 +496,68 @@ FontFaceCache* fontFaceCache()
     return &cache;
 }
 
+ImageCache::~ImageCache()
+{
+    evict(0);
+}
+
+plutovg_surface_t* ImageCache::getImage(const std::string& href)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_table.find(href);
+    if(it == m_table.end())
+        return nullptr;
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    return plutovg_surface_reference(it->second->surface);
+}
+
+void ImageCache::addImage(const std::string& href, plutovg_surface_t* surface)
+{
+    if(surface == nullptr)
+        return;
+    size_t size = href.size() + plutovg_surface_get_stride(surface) * plutovg_surface_get_height(surface);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(size > m_capacity)
+        return;
+    auto it = m_table.find(href);
+    if(it != m_table.end()) {
+        m_size -= it->second->size;
+        plutovg_surface_destroy(it->second->surface);
+        auto entry = it->second;
+        m_table.erase(it);
+        m_entries.erase(entry);
+    }
+
+    evict(m_capacity - size);
+    m_entries.push_front({href, size, plutovg_surface_reference(surface)});
+    m_table.emplace(m_entries.front().href, m_entries.begin());
+    m_size += size;
+}
+
+void ImageCache::setCapacity(size_t capacity)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_capacity = capacity;
+    evict(capacity);
+}
+
+void ImageCache::evict(size_t capacity)
+{
+    while(m_size > capacity && !m_entries.empty()) {
+        const auto& entry = m_entries.back();
+        m_size -= entry.size;
+        plutovg_surface_destroy(entry.surface);
+        m_table.erase(entry.href);
+        m_entries.pop_back();
+    }
+}
+
+ImageCache* imageCache()
+{
+    static ImageCache cache;
+    return &cache;
+}
+
 Font::Font(const FontFace& face, float size)
     : m_face(face), m_size(size)
 {
@@ -533,6 +626,7 @@ void Canvas::setRadialGradient(float cx, float cy, float r, float fx, float fy,
 void Canvas::setTexture(const Canvas& source, TextureType type, float opacity, const Transform& transform)
 {
     plutovg_canvas_set_texture(m_canvas, source.surface(), static_cast<plutovg_texture_type_t>(type), opacity, &transform.matrix());
+    plutovg_canvas_set_texture_filter(m_canvas, PLUTOVG_TEXTURE_FILTER_NEAREST);
 }
 
 void Canvas::fillPath(const Path& path, FillRule fillRule, const Transform& transform)
@@ -558,17 +652,27 @@ void Canvas::strokePath(const Path& path, const StrokeData& strokeData, const Tr
     plutovg_canvas_stroke_path(m_canvas, path.data());
 }
 
-void Canvas::fillText(const std::u32string_view& text, const Font& font, const Point& origin, const Transform& transform)
+static std::vector<plutovg_text_run_t> toTextRuns(const TextRunList& runs)
+{
+    std::vector<plutovg_text_run_t> textRuns;
+    textRuns.reserve(runs.size());
+    for(const auto& run : runs)
+        textRuns.push_back({run.text.data(), static_cast<int>(run.text.length()), run.origin.x, run.origin.y});
+    return textRuns;
+}
+
+void Canvas::fillText(const TextRunList& runs, const Font& font, const Transform& transform)
 {
     plutovg_canvas_set_matrix(m_canvas, &m_translation);
     plutovg_canvas_transform(m_canvas, &transform.matrix());
     plutovg_canvas_set_fill_rule(m_canvas, PLUTOVG_FILL_RULE_NON_ZERO);
     plutovg_canvas_set_operator(m_canvas, PLUTOVG_OPERATOR_SRC_OVER);
     plutovg_canvas_set_font(m_canvas, font.face().get(), font.size());
-    plutovg_canvas_fill_text(m_canvas, text.data(), text.length(), PLUTOVG_TEXT_ENCODING_UTF32, origin.x, origin.y);
+    auto textRuns = toTextRuns(runs);
+    plutovg_canvas_fill_text_runs(m_canvas, textRuns.data(), textRuns.size(), PLUTOVG_TEXT_ENCODING_UTF32);
 }
 
-void Canvas::strokeText(const std::u32string_view& text, float strokeWidth, const Font& font, const Point& origin, const Transform& transform)
+void Canvas::strokeText(const TextRunList& runs, float strokeWidth, const Font& font, const Transform& transform)
 {
     plutovg_canvas_set_matrix(m_canvas, &m_translation);
     plutovg_canvas_transform(m_canvas, &transform.matrix());
@@ -580,7 +684,8 @@ void Canvas::strokeText(const std::u32string_view& text, float strokeWidth, cons
     plutovg_canvas_set_dash_array(m_canvas, nullptr, 0);
     plutovg_canvas_set_operator(m_canvas, PLUTOVG_OPERATOR_SRC_OVER);
     plutovg_canvas_set_font(m_canvas, font.face().get(), font.size());
-    plutovg_canvas_stroke_text(m_canvas, text.data(), text.length(), PLUTOVG_TEXT_ENCODING_UTF32, origin.x, origin.y);
+    auto textRuns = toTextRuns(runs);
+    plutovg_canvas_stroke_text_runs(m_canvas, textRuns.data(), textRuns.size(), PLUTOVG_TEXT_ENCODING_UTF32);
 }
 
 void Canvas::clipPath(const Path& path, FillRule clipRule, const Transform& transform)
@@ -599,7 +704,7 @@ void Canvas::clipRect(const Rect& rect, FillRule clipRule, const Transform& tran
     plutovg_canvas_clip_rect(m_canvas, rect.x, rect.y, rect.w, rect.h);
 }
 
-void Canvas::drawImage(const Bitmap& image, const Rect& dstRect, const Rect& srcRect, const Transform& transform)
+void Canvas::drawImage(const Bitmap& image, const Rect& dstRect, const Rect& srcRect, const Transform& transform, TextureFilter filter)
 {
     auto xScale = dstRect.w / srcRect.w;
     auto yScale = dstRect.h / srcRect.h;
@@ -610,6 +715,7 @@ void Canvas::drawImage(const Bitmap& image, const Rect& dstRect, const Rect& src
     plutovg_canvas_set_fill_rule(m_canvas, PLUTOVG_FILL_RULE_NON_ZERO);
     plutovg_canvas_set_operator(m_canvas, PLUTOVG_OPERATOR_SRC_OVER);
     plutovg_canvas_set_texture(m_canvas, image.surface(), PLUTOVG_TEXTURE_TYPE_PLAIN, 1.f, &matrix);
+    plutovg_canvas_set_texture_filter(m_canvas, static_cast<plutovg_texture_filter_t>(filter));
     plutovg_canvas_fill_rect(m_canvas, 0, 0, dstRect.w, dstRect.h);
 }
 
@@ -666,6 +772,8 @@ void Canvas::convertToLuminanceMask()
             pixels[x] = static_cast<uint32_t>(l * (a / 255.0)) << 24;
         }
     }
+
+    plutovg_surface_mark_dirty(m_surface);
 }
 
 Canvas::~Canvas()
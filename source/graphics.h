@@ -10,6 +10,11 @@
 #include <vector>
 #include <array>
 #include <string>
+#include <string_view>
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
 
 namespace lunasvg {
 
@@ -420,16 +425,50 @@ private:
 class FontFaceCache {
 public:
     bool addFontFace(const std::string& family, bool bold, bool italic, const FontFace& face);
+    int addFontCollection(const void* data, size_t length, plutovg_destroy_func_t destroy_func, void* closure);
     FontFace getFontFace(const std::string& family, bool bold, bool italic) const;
 
+    unsigned generation() const { return m_generation.load(std::memory_order_acquire); }
+
 private:
     FontFaceCache();
     plutovg_font_face_cache_t* m_cache;
+    std::atomic<unsigned> m_generation{0};
     friend FontFaceCache* fontFaceCache();
 };
 
 FontFaceCache* fontFaceCache();
 
+class ImageCache {
+public:
+    plutovg_surface_t* getImage(const std::string& href);
+    void addImage(const std::string& href, plutovg_surface_t* surface);
+    void setCapacity(size_t capacity);
+
+private:
+    ImageCache() = default;
+    ~ImageCache();
+
+    struct Entry {
+        std::string href;
+        size_t size;
+        plutovg_surface_t* surface;
+    };
+
+    using EntryList = std::list<Entry>;
+
+    void evict(size_t capacity);
+
+    EntryList m_entries;
+    std::unordered_map<std::string_view, EntryList::iterator> m_table;
+    std::mutex m_mutex;
+    size_t m_capacity = 64 * 1024 * 1024;
+    size_t m_size = 0;
+    friend ImageCache* imageCache();
+};
+
+ImageCache* imageCache();
+
 class Font {
 public:
     Font() = default;
@@ -461,6 +500,11 @@ enum class TextureType {
     Tiled = PLUTOVG_TEXTURE_TYPE_TILED
 };
 
+enum class TextureFilter {
+    Nearest = PLUTOVG_TEXTURE_FILTER_NEAREST,
+    Bilinear = PLUTOVG_TEXTURE_FILTER_BILINEAR
+};
+
 enum class BlendMode {
     Src = PLUTOVG_OPERATOR_SRC,
     Src_Over = PLUTOVG_OPERATOR_SRC_OVER,
@@ -504,6 +548,14 @@ private:
 using GradientStop = plutovg_gradient_stop_t;
 using GradientStops = std::vector<GradientStop>;
 
+struct TextRun {
+    TextRun(const std::u32string_view& text, const Point& origin) : text(text), origin(origin) {}
+    std::u32string_view text;
+    Point origin;
+};
+
+using TextRunList = std::vector<TextRun>;
+
 class Bitmap;
 
 class Canvas {
@@ -521,13 +573,13 @@ public:
     void fillPath(const Path& path, FillRule fillRule, const Transform& transform);
     void strokePath(const Path& path, const StrokeData& strokeData, const Transform& transform);
 
-    void fillText(const std::u32string_view& text, const Font& font, const Point& origin, const Transform& transform);
-    void strokeText(const std::u32string_view& text, float strokeWidth, const Font& font, const Point& origin, const Transform& transform);
+    void fillText(const TextRunList& runs, const Font& font, const Transform& transform);
+    void strokeText(const TextRunList& runs, float strokeWidth, const Font& font, const Transform& transform);
 
     void clipPath(const Path& path, FillRule clipRule, const Transform& transform);
     void clipRect(const Rect& rect, FillRule clipRule, const Transform& transform);
 
-    void drawImage(const Bitmap& image, const Rect& dstRect, const Rect& srcRect, const Transform& transform);
+    void drawImage(const Bitmap& image, const Rect& dstRect, const Rect& srcRect, const Transform& transform, TextureFilter filter);
     void blendCanvas(const Canvas& canvas, BlendMode blendMode, float opacity);
 
     void save();
@@ -26,6 +26,16 @@ bool lunasvg_add_font_face_from_data(const char* family, bool bold, bool italic,
     return lunasvg::fontFaceCache()->addFontFace(family, bold, italic, lunasvg::FontFace(data, length, destroy_func, closure));
 }
 
+int lunasvg_add_font_collection_from_data(const void* data, size_t length, lunasvg_destroy_func_t destroy_func, void* closure)
+{
+    return lunasvg::fontFaceCache()->addFontCollection(data, length, destroy_func, closure);
+}
+
+void lunasvg_set_image_cache_capacity(size_t capacity)
+{
+    lunasvg::imageCache()->setCapacity(capacity);
+}
+
 namespace lunasvg {
 
 Bitmap::Bitmap(int width, int height)
@@ -110,6 +120,23 @@ void Bitmap::convertToRGBA()
     auto height = plutovg_surface_get_height(m_surface);
     auto stride = plutovg_surface_get_stride(m_surface);
     plutovg_convert_argb_to_rgba(data, data, width, height, stride);
+    plutovg_surface_mark_dirty(m_surface);
+}
+
+static_assert(static_cast<int>(PixelFormat::ARGB32_Premultiplied) == PLUTOVG_PIXEL_FORMAT_ARGB32_PREMULTIPLIED, "unexpected PixelFormat value");
+static_assert(static_cast<int>(PixelFormat::RGBA32_Premultiplied) == PLUTOVG_PIXEL_FORMAT_RGBA32_PREMULTIPLIED, "unexpected PixelFormat value");
+static_assert(static_cast<int>(PixelFormat::RGBA32) == PLUTOVG_PIXEL_FORMAT_RGBA32, "unexpected PixelFormat value");
+static_assert(static_cast<int>(PixelFormat::BGRA32_Premultiplied) == PLUTOVG_PIXEL_FORMAT_BGRA32_PREMULTIPLIED, "unexpected PixelFormat value");
+static_assert(static_cast<int>(PixelFormat::A8) == PLUTOVG_PIXEL_FORMAT_A8, "unexpected PixelFormat value");
+
+static_assert(static_cast<int>(PngFilter::None) == PLUTOVG_PNG_FILTER_NONE, "unexpected PngFilter value");
+static_assert(static_cast<int>(PngFilter::Adaptive) == PLUTOVG_PNG_FILTER_ADAPTIVE, "unexpected PngFilter value");
+
+bool Bitmap::convertTo(PixelFormat format, uint8_t* data, int stride) const
+{
+    if(m_surface == nullptr || data == nullptr)
+        return false;
+    return plutovg_surface_convert_to(m_surface, data, stride, static_cast<plutovg_pixel_format_t>(format));
 }
 
 Bitmap& Bitmap::operator=(Bitmap&& bitmap)
@@ -132,6 +159,62 @@ bool Bitmap::writeToPng(lunasvg_write_func_t callback, void* closure) const
     return false;
 }
 
+bool Bitmap::writeToPng(const std::string& filename, int compressionLevel, PngFilter filter) const
+{
+    if(m_surface)
+        return plutovg_surface_write_to_png_with_options(m_surface, filename.data(), compressionLevel, static_cast<plutovg_png_filter_t>(filter));
+    return false;
+}
+
+bool Bitmap::writeToPng(lunasvg_write_func_t callback, void* closure, int compressionLevel, PngFilter filter) const
+{
+    if(m_surface)
+        return plutovg_surface_write_to_png_stream_with_options(m_surface, callback, closure, compressionLevel, static_cast<plutovg_png_filter_t>(filter));
+    return false;
+}
+
+bool Bitmap::writeToQoi(const std::string& filename) const
+{
+    if(m_surface)
+        return plutovg_surface_write_to_qoi(m_surface, filename.data());
+    return false;
+}
+
+bool Bitmap::writeToQoi(lunasvg_write_func_t callback, void* closure) const
+{
+    if(m_surface)
+        return plutovg_surface_write_to_qoi_stream(m_surface, callback, closure);
+    return false;
+}
+
+bool Bitmap::writeToPam(const std::string& filename) const
+{
+    if(m_surface)
+        return plutovg_surface_write_to_pam(m_surface, filename.data());
+    return false;
+}
+
+bool Bitmap::writeToPam(lunasvg_write_func_t callback, void* closure) const
+{
+    if(m_surface)
+        return plutovg_surface_write_to_pam_stream(m_surface, callback, closure);
+    return false;
+}
+
+bool Bitmap::writeToPpm(const std::string& filename) const
+{
+    if(m_surface)
+        return plutovg_surface_write_to_ppm(m_surface, filename.data());
+    return false;
+}
+
+bool Bitmap::writeToPpm(lunasvg_write_func_t callback, void* closure) const
+{
+    if(m_surface)
+        return plutovg_surface_write_to_ppm_stream(m_surface, callback, closure);
+    return false;
+}
+
 plutovg_surface_t* Bitmap::release()
 {
     return std::exchange(m_surface, nullptr);
@@ -480,6 +563,32 @@ void Document::render(Bitmap& bitmap, const Matrix& matrix) const
     rootElement(true)->render(state);
 }
 
+bool Document::renderToBuffer(uint8_t* data, int width, int height, int stride, PixelFormat format, const Matrix& matrix) const
+{
+    if(data == nullptr || width <= 0 || height <= 0)
+        return false;
+    auto pixelFormat = static_cast<plutovg_pixel_format_t>(format);
+    if(stride < width * plutovg_pixel_format_get_bytes_per_pixel(pixelFormat))
+        return false;
+    if(stride < width * 4) {
+        Bitmap bitmap(width, height);
+        if(bitmap.isNull())
+            return false;
+        render(bitmap, matrix);
+        return bitmap.convertTo(format, data, stride);
+    }
+
+    for(int y = 0; y < height; ++y)
+        std::memset(data + stride * y, 0, width * 4);
+    Bitmap bitmap(data, width, height, stride);
+    if(bitmap.isNull())
+        return false;
+    render(bitmap, matrix);
+    if(!plutovg_pixel_format_is_native(pixelFormat))
+        plutovg_convert_argb_to_format(data, stride, data, stride, width, height, pixelFormat);
+    return true;
+}
+
 Bitmap Document::renderToBitmap(int width, int height, uint32_t backgroundColor) const
 {
     auto intrinsicWidth = rootElement(true)->intrinsicWidth();
@@ -5,6 +5,7 @@
 #include "svgproperty.h"
 #include "svglayoutstate.h"
 #include "svgrenderstate.h"
+#include "svgparserutils.h"
 
 #include <cassert>
 
@@ -696,6 +697,50 @@ void SVGRootElement::addElementById(const std::string& id, SVGElement* element)
     m_idCache.emplace(id, element);
 }
 
+static FontFace resolveFontFace(std::string_view input, bool bold, bool italic)
+{
+    FontFace face;
+    while(!input.empty() && face.isNull()) {
+        auto family = input.substr(0, input.find(','));
+        input.remove_prefix(family.length());
+        if(!input.empty() && input.front() == ',')
+            input.remove_prefix(1);
+        stripLeadingAndTrailingSpaces(family);
+        if(!family.empty() && (family.front() == '\'' || family.front() == '"')) {
+            auto quote = family.front();
+            family.remove_prefix(1);
+            if(!family.empty() && family.back() == quote)
+                family.remove_suffix(1);
+            stripLeadingAndTrailingSpaces(family);
+        }
+
+        std::string font_family(family);
+        if(!font_family.empty()) {
+            face = fontFaceCache()->getFontFace(font_family, bold, italic);
+        }
+    }
+
+    if(face.isNull())
+        face = fontFaceCache()->getFontFace(emptyString, bold, italic);
+    return face;
+}
+
+const FontFace& SVGRootElement::getFontFace(const std::string& family, bool bold, bool italic)
+{
+    if(m_fontFaceGeneration != fontFaceCache()->generation()) {
+        m_fontFaceGeneration = fontFaceCache()->generation();
+        for(auto& fontFaces : m_fontFaces) {
+            fontFaces.clear();
+        }
+    }
+
+    auto& fontFaces = m_fontFaces[bold | italic << 1];
+    auto it = fontFaces.find(family);
+    if(it == fontFaces.end())
+        it = fontFaces.emplace(family, resolveFontFace(family, bold, italic)).first;
+    return it->second;
+}
+
 void SVGRootElement::layout(SVGLayoutState& state)
 {
     SVGSVGElement::layout(state);
@@ -882,44 +927,63 @@ Rect SVGImageElement::strokeBoundingBox() const
 
 void SVGImageElement::render(SVGRenderState& state) const
 {
-    if(m_image.isNull() || isDisplayNone() || isVisibilityHidden())
+    if(isDisplayNone() || isVisibilityHidden())
         return;
     Rect dstRect(fillBoundingBox());
-    Rect srcRect(0, 0, m_image.width(), m_image.height());
-    if(dstRect.isEmpty() || srcRect.isEmpty())
+    if(dstRect.isEmpty())
+        return;
+    const auto& image = this->image();
+    Rect srcRect(0, 0, image.width(), image.height());
+    if(srcRect.isEmpty())
         return;
     m_preserveAspectRatio.transformRect(dstRect, srcRect);
 
     SVGBlendInfo blendInfo(this);
     SVGRenderState newState(this, state, localTransform());
     newState.beginGroup(blendInfo);
-    newState->drawImage(m_image, dstRect, srcRect, newState.currentTransform());
+    auto filter = m_image_rendering == ImageRendering::OptimizeSpeed ? TextureFilter::Nearest : TextureFilter::Bilinear;
+    newState->drawImage(image, dstRect, srcRect, newState.currentTransform(), filter);
     newState.endGroup(blendInfo);
 }
 
 static Bitmap loadImageResource(const std::string& href)
 {
-    if(href.compare(0, 5, "data:") == 0) {
-        std::string_view input(href);
-        auto index = input.find(',', 5);
-        if(index == std::string_view::npos)
-            return Bitmap();
-        input.remove_prefix(index + 1);
-        return plutovg_surface_load_from_image_base64(input.data(), input.length());
-    }
-
-    return plutovg_surface_load_from_image_file(href.data());
+    if(href.empty())
+        return Bitmap();
+    if(href.compare(0, 5, "data:") != 0)
+        return plutovg_surface_load_from_image_file(href.data());
+    if(auto surface = imageCache()->getImage(href))
+        return surface;
+    std::string_view input(href);
+    auto index = input.find(',', 5);
+    if(index == std::string_view::npos)
+        return Bitmap();
+    input.remove_prefix(index + 1);
+    Bitmap image(plutovg_surface_load_from_image_base64(input.data(), input.length()));
+    imageCache()->addImage(href, image.surface());
+    return image;
 }
 
 void SVGImageElement::parseAttribute(PropertyID id, const std::string& value)
 {
     if(id == PropertyID::Href) {
-        m_image = loadImageResource(value);
+        m_image = Bitmap();
+        m_imageLoaded = false;
     } else {
         SVGGraphicsElement::parseAttribute(id, value);
     }
 }
 
+void SVGImageElement::layoutElement(const SVGLayoutState& state)
+{
+    m_image_rendering = state.image_rendering();
+    SVGGraphicsElement::layoutElement(state);
+    if(m_imageLoaded || isDisplayNone() || isVisibilityHidden() || fillBoundingBox().isEmpty())
+        return;
+    m_image = loadImageResource(getAttribute(PropertyID::Href));
+    m_imageLoaded = true;
+}
+
 SVGSymbolElement::SVGSymbolElement(Document* document)
     : SVGGraphicsElement(document, ElementID::Symbol)
     , SVGFitToViewBox(this)
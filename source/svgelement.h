@@ -8,6 +8,7 @@
 #include <forward_list>
 #include <list>
 #include <map>
+#include <unordered_map>
 
 namespace lunasvg {
 
@@ -352,8 +353,12 @@ public:
 
     void forceLayout();
 
+    const FontFace& getFontFace(const std::string& family, bool bold, bool italic);
+
 private:
     std::map<std::string, SVGElement*, std::less<>> m_idCache;
+    std::unordered_map<std::string, FontFace> m_fontFaces[4];
+    unsigned m_fontFaceGeneration{0};
     float m_intrinsicWidth{-1.f};
     float m_intrinsicHeight{-1.f};
 };
@@ -394,6 +399,7 @@ public:
     Rect strokeBoundingBox() const final;
     void render(SVGRenderState& state) const final;
     void parseAttribute(PropertyID id, const std::string& value) final;
+    void layoutElement(const SVGLayoutState& state) final;
 
 private:
     SVGLength m_x;
@@ -401,7 +407,9 @@ private:
     SVGLength m_width;
     SVGLength m_height;
     SVGPreserveAspectRatio m_preserveAspectRatio;
+    ImageRendering m_image_rendering = ImageRendering::Auto;
     Bitmap m_image;
+    bool m_imageLoaded = false;
 };
 
 class SVGSymbolElement final : public SVGGraphicsElement, public SVGFitToViewBox {
@@ -373,6 +373,18 @@ static MaskType parseMaskType(const std::string_view& input)
     return parseEnumValue(input, entries, MaskType::Luminance);
 }
 
+static ImageRendering parseImageRendering(const std::string_view& input)
+{
+    static const SVGEnumerationEntry<ImageRendering> entries[] = {
+        {ImageRendering::Auto, "auto"},
+        {ImageRendering::OptimizeSpeed, "optimizeSpeed"},
+        {ImageRendering::OptimizeSpeed, "crisp-edges"},
+        {ImageRendering::OptimizeSpeed, "pixelated"}
+    };
+
+    return parseEnumValue(input, entries, ImageRendering::Auto);
+}
+
 static FillRule parseFillRule(const std::string_view& input)
 {
     static const SVGEnumerationEntry<FillRule> entries[] = {
@@ -435,6 +447,7 @@ SVGLayoutState::SVGLayoutState(const SVGLayoutState& parent, const SVGElement* e
     , m_visibility(parent.visibility())
     , m_overflow(element->isRootElement() ? Overflow::Visible : Overflow::Hidden)
     , m_pointer_events(parent.pointer_events())
+    , m_image_rendering(parent.image_rendering())
     , m_marker_start(parent.marker_start())
     , m_marker_mid(parent.marker_mid())
     , m_marker_end(parent.marker_end())
@@ -548,6 +561,9 @@ SVGLayoutState::SVGLayoutState(const SVGLayoutState& parent, const SVGElement* e
         case PropertyID::Mask_Type:
             m_mask_type = parseMaskType(input);
             break;
+        case PropertyID::Image_Rendering:
+            m_image_rendering = parseImageRendering(input);
+            break;
         case PropertyID::Mask:
             m_mask = parseUrl(input);
             break;
@@ -577,30 +593,7 @@ Font SVGLayoutState::font() const
     auto bold = m_font_weight == FontWeight::Bold;
     auto italic = m_font_style == FontStyle::Italic;
 
-    FontFace face;
-    std::string_view input(m_font_family);
-    while(!input.empty() && face.isNull()) {
-        auto family = input.substr(0, input.find(','));
-        input.remove_prefix(family.length());
-        if(!input.empty() && input.front() == ',')
-            input.remove_prefix(1);
-        stripLeadingAndTrailingSpaces(family);
-        if(!family.empty() && (family.front() == '\'' || family.front() == '"')) {
-            auto quote = family.front();
-            family.remove_prefix(1);
-            if(!family.empty() && family.back() == quote)
-                family.remove_suffix(1);
-            stripLeadingAndTrailingSpaces(family);
-        }
-
-        std::string font_family(family);
-        if(!font_family.empty()) {
-            face = fontFaceCache()->getFontFace(font_family, bold, italic);
-        }
-    }
-
-    if(face.isNull())
-        face = fontFaceCache()->getFontFace(emptyString, bold, italic);
+    const auto& face = m_element->rootElement()->getFontFace(m_font_family, bold, italic);
     return Font(face, m_font_size);
 }
 
@@ -57,6 +57,7 @@ public:
     Overflow overflow() const { return m_overflow; }
     PointerEvents pointer_events() const { return m_pointer_events; }
     MaskType mask_type() const { return m_mask_type; }
+    ImageRendering image_rendering() const { return m_image_rendering; }
 
     const std::string& mask() const { return m_mask; }
     const std::string& clip_path() const { return m_clip_path; }
@@ -115,6 +116,7 @@ private:
     Overflow m_overflow = Overflow::Visible;
     PointerEvents m_pointer_events = PointerEvents::Auto;
     MaskType m_mask_type = MaskType::Luminance;
+    ImageRendering m_image_rendering = ImageRendering::Auto;
 
     std::string m_mask;
     std::string m_clip_path;
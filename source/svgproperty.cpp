@@ -88,6 +88,7 @@ PropertyID csspropertyid(const std::string_view& name)
         {"font-size", PropertyID::Font_Size},
         {"font-style", PropertyID::Font_Style},
         {"font-weight", PropertyID::Font_Weight},
+        {"image-rendering", PropertyID::Image_Rendering},
         {"letter-spacing", PropertyID::Letter_Spacing},
         {"marker-end", PropertyID::Marker_End},
         {"marker-mid", PropertyID::Marker_Mid},
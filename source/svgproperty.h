@@ -38,6 +38,7 @@ enum class PropertyID : uint8_t {
     Height,
     Href,
     Id,
+    Image_Rendering,
     LengthAdjust,
     Letter_Spacing,
     Marker_End,
@@ -246,6 +247,11 @@ enum class MaskType : uint8_t {
     Alpha
 };
 
+enum class ImageRendering : uint8_t {
+    Auto,
+    OptimizeSpeed
+};
+
 enum class Units : uint8_t {
     UserSpaceOnUse,
     ObjectBoundingBox
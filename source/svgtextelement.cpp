@@ -444,6 +444,76 @@ void SVGTextFragmentsBuilder::fillCharacterPositions(const SVGTextPosition& posi
     }
 }
 
+SVGTextLayoutKeyBuilder::SVGTextLayoutKeyBuilder(std::string& key)
+    : m_key(key)
+{
+    m_key.clear();
+}
+
+void SVGTextLayoutKeyBuilder::build(const SVGTextElement* textElement)
+{
+    handleElement(textElement);
+}
+
+void SVGTextLayoutKeyBuilder::handleElement(const SVGTextPositioningElement* element)
+{
+    append(element);
+    append(element->isDisplayNone());
+    if(element->isDisplayNone())
+        return;
+    const auto& font = element->font();
+    append(font.face().get());
+    append(font.size());
+    append(element->letter_spacing());
+    append(element->word_spacing());
+    append(element->baseline_offset());
+    append(element->alignment_baseline());
+    append(element->dominant_baseline());
+    append(element->text_anchor());
+    append(element->white_space());
+    append(element->direction());
+    append(element->isVerticalWritingMode());
+    append(element->isUprightTextOrientation());
+
+    appendLengthList(element, element->x(), LengthDirection::Horizontal);
+    appendLengthList(element, element->y(), LengthDirection::Vertical);
+    appendLengthList(element, element->dx(), LengthDirection::Horizontal);
+    appendLengthList(element, element->dy(), LengthDirection::Vertical);
+    append(element->rotate().size());
+    appendBytes(element->rotate().data(), element->rotate().size() * sizeof(float));
+
+    LengthContext lengthContext(element);
+    append(element->hasAttribute(PropertyID::TextLength));
+    append(lengthContext.valueForLength(element->textLength()));
+    append(element->lengthAdjust());
+    for(const auto& child : element->children()) {
+        if(child->isTextNode()) {
+            const auto& data = toSVGTextNode(child.get())->data();
+            append(child.get());
+            append(data.length());
+            appendBytes(data.data(), data.length());
+        } else if(child->isTextPositioningElement()) {
+            handleElement(toSVGTextPositioningElement(child.get()));
+        }
+    }
+
+    append(element);
+}
+
+void SVGTextLayoutKeyBuilder::appendLengthList(const SVGTextPositioningElement* element, const LengthList& lengths, LengthDirection direction)
+{
+    LengthContext lengthContext(element);
+    append(lengths.size());
+    for(const auto& length : lengths) {
+        append(lengthContext.valueForLength(length, direction));
+    }
+}
+
+void SVGTextLayoutKeyBuilder::appendBytes(const void* data, size_t length)
+{
+    m_key.append(static_cast<const char*>(data), length);
+}
+
 SVGTextPositioningElement::SVGTextPositioningElement(Document* document, ElementID id)
     : SVGGraphicsElement(document, id)
     , m_x(PropertyID::X, LengthDirection::Horizontal, LengthNegativeMode::Allow)
@@ -518,9 +588,46 @@ SVGTextElement::SVGTextElement(Document* document)
 void SVGTextElement::layout(SVGLayoutState& state)
 {
     SVGTextPositioningElement::layout(state);
+
+    // The fragments only depend on the text content and the resolved text
+    // properties, so they are kept as long as those are unchanged.
+    std::string layoutKey;
+    SVGTextLayoutKeyBuilder(layoutKey).build(this);
+    if(layoutKey == m_layoutKey)
+        return;
+    m_layoutKey.swap(layoutKey);
     SVGTextFragmentsBuilder(m_text, m_fragments).build(this);
 }
 
+static Transform fragmentTransform(const Transform& currentTransform, const SVGTextFragment& fragment)
+{
+    return currentTransform * Transform::rotated(fragment.angle, fragment.x, fragment.y) * fragment.lengthAdjustTransform;
+}
+
+static bool isSameTransform(const Transform& a, const Transform& b)
+{
+    const auto& m = a.matrix();
+    const auto& n = b.matrix();
+    return m.a == n.a && m.b == n.b && m.c == n.c && m.d == n.d && m.e == n.e && m.f == n.f;
+}
+
+static bool isSamePaint(const SVGPaintServer& a, const SVGPaintServer& b)
+{
+    return a.element() == b.element() && a.color().value() == b.color().value() && a.opacity() == b.opacity();
+}
+
+static bool isSameTextStyle(const SVGTextPositioningElement* a, const SVGTextPositioningElement* b)
+{
+    if(a == b)
+        return true;
+    if(b->isVisibilityHidden())
+        return false;
+    const auto& fontA = a->font();
+    const auto& fontB = b->font();
+    return fontA.face().get() == fontB.face().get() && fontA.size() == fontB.size() && a->stroke_width() == b->stroke_width()
+        && isSamePaint(a->fill(), b->fill()) && isSamePaint(a->stroke(), b->stroke());
+}
+
 void SVGTextElement::render(SVGRenderState& state) const
 {
     if(m_fragments.empty() || isVisibilityHidden() || isDisplayNone())
@@ -533,24 +640,34 @@ void SVGTextElement::render(SVGRenderState& state) const
     }
 
     std::u32string_view wholeText(m_text);
-    for(const auto& fragment : m_fragments) {
-        if(fragment.element->isVisibilityHidden())
+    TextRunList runs;
+    auto it = m_fragments.begin();
+    while(it != m_fragments.end()) {
+        const auto& fragment = *it;
+        if(fragment.element->isVisibilityHidden()) {
+            ++it;
             continue;
-        auto transform = newState.currentTransform() * Transform::rotated(fragment.angle, fragment.x, fragment.y) * fragment.lengthAdjustTransform;
-        auto text = wholeText.substr(fragment.offset, fragment.length);
-        auto origin = Point(fragment.x, fragment.y);
+        }
+
+        runs.clear();
+        auto transform = fragmentTransform(newState.currentTransform(), fragment);
+        do {
+            runs.emplace_back(wholeText.substr(it->offset, it->length), Point(it->x, it->y));
+            ++it;
+        } while(it != m_fragments.end() && isSameTextStyle(fragment.element, it->element)
+            && isSameTransform(transform, fragmentTransform(newState.currentTransform(), *it)));
 
         const auto& font = fragment.element->font();
         if(newState.mode() == SVGRenderMode::Clipping) {
-            newState->fillText(text, font, origin, transform);
+            newState->fillText(runs, font, transform);
         } else {
             const auto& fill = fragment.element->fill();
             const auto& stroke = fragment.element->stroke();
             auto stroke_width = fragment.element->stroke_width();
             if(fill.applyPaint(newState))
-                newState->fillText(text, font, origin, transform);
+                newState->fillText(runs, font, transform);
             if(stroke.applyPaint(newState)) {
-                newState->strokeText(text, stroke_width, font, origin, transform);
+                newState->strokeText(runs, stroke_width, font, transform);
             }
         }
     }
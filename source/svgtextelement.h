@@ -67,6 +67,22 @@ private:
     float m_y = 0;
 };
 
+class SVGTextLayoutKeyBuilder {
+public:
+    explicit SVGTextLayoutKeyBuilder(std::string& key);
+
+    void build(const SVGTextElement* textElement);
+
+private:
+    void handleElement(const SVGTextPositioningElement* element);
+    void appendLengthList(const SVGTextPositioningElement* element, const LengthList& lengths, LengthDirection direction);
+    void appendBytes(const void* data, size_t length);
+
+    template<typename T>
+    void append(const T& value) { appendBytes(&value, sizeof(value)); }
+    std::string& m_key;
+};
+
 class SVGTextPositioningElement : public SVGGraphicsElement {
 public:
     SVGTextPositioningElement(Document* document, ElementID id);
@@ -148,6 +164,7 @@ private:
     Rect boundingBox(bool includeStroke) const;
     SVGTextFragmentList m_fragments;
     std::u32string m_text;
+    std::string m_layoutKey;
 };
 
 } // namespace lunasvg